@@ -0,0 +1,95 @@
+/*
+ * Latency of the blocking collectives that AMPI can run node-locally
+ * (see AMPI_NODE_LOCAL_COLL in the AMPI manual). Run the same binary at
+ * several virtualization ratios, with and without AMPI_NODE_LOCAL_COLL=1,
+ * to compare the shared-memory path against the regular one.
+ */
+#include "mpi.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_COLLS 5
+
+static const char* collNames[NUM_COLLS] = {
+  "Bcast", "Allreduce", "Allgather", "Alltoall", "Reduce_scatter"
+};
+
+static void runColl(int which, char* sbuf, char* rbuf, int count, int* counts, int p)
+{
+  switch (which)
+  {
+    case 0:
+      MPI_Bcast(sbuf, count, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+      break;
+    case 1:
+      MPI_Allreduce(sbuf, rbuf, count, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+      break;
+    case 2:
+      MPI_Allgather(sbuf, count, MPI_DOUBLE, rbuf, count, MPI_DOUBLE, MPI_COMM_WORLD);
+      break;
+    case 3:
+      MPI_Alltoall(sbuf, count, MPI_DOUBLE, rbuf, count, MPI_DOUBLE, MPI_COMM_WORLD);
+      break;
+    case 4:
+      MPI_Reduce_scatter(sbuf, rbuf, counts, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+      break;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  int my_id, p, i, k, count, max_iters;
+  int* counts;
+  char *sbuf, *rbuf;
+  double startTime, elapsed;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_id);
+  MPI_Comm_size(MPI_COMM_WORLD, &p);
+
+  if (argc < 2 || sscanf(argv[1], "%d", &count) < 1)
+  {
+    if (my_id == 0) fprintf(stderr, "need number of doubles per rank as param\n");
+    MPI_Finalize();
+    return 1;
+  }
+
+  max_iters = 100;
+  if (argc > 2) sscanf(argv[2], "%d", &max_iters);
+
+  sbuf = (char*)malloc(sizeof(double) * count * p);
+  rbuf = (char*)malloc(sizeof(double) * count * p);
+  counts = (int*)malloc(sizeof(int) * p);
+  memset(sbuf, 0, sizeof(double) * count * p);
+  for (i = 0; i < p; i++) counts[i] = count;
+
+  if (my_id == 0)
+  {
+    printf("Collective latency on %d ranks, %d doubles per rank, %d iterations\n",
+           p, count, max_iters);
+  }
+
+  for (k = 0; k < NUM_COLLS; k++)
+  {
+    /* warm up, so that one-time setup is not timed */
+    runColl(k, sbuf, rbuf, count, counts, p);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    startTime = MPI_Wtime();
+    for (i = 0; i < max_iters; i++)
+      runColl(k, sbuf, rbuf, count, counts, p);
+    elapsed = (MPI_Wtime() - startTime) / max_iters;
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    if (my_id == 0)
+      printf("%-16s %10.3f us\n", collNames[k], elapsed * 1e6);
+  }
+
+  free(sbuf);
+  free(rbuf);
+  free(counts);
+
+  MPI_Finalize();
+  return 0;
+}
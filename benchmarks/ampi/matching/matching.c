@@ -0,0 +1,98 @@
+/*
+ * Message matching stress test: each even rank posts many nonblocking
+ * receives with distinct tags and its odd partner sends them in the
+ * opposite order (posted queue), then the partner sends everything
+ * before any receive is posted and the receives are done in the
+ * opposite order (unexpected queue). With linear matching queues both
+ * phases cost O(n^2) comparisons.
+ */
+#include "mpi.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char** argv)
+{
+  int my_id, p, partner, i, k, n, max_iters, errors = 0, allErrors;
+  int *buf;
+  MPI_Request* reqs;
+  double startTime, postedTime = 0, unexpectedTime = 0;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_id);
+  MPI_Comm_size(MPI_COMM_WORLD, &p);
+
+  if (argc < 2 || sscanf(argv[1], "%d", &n) < 1 || p % 2 != 0)
+  {
+    if (my_id == 0) fprintf(stderr, "need number of messages as param and an even number of ranks\n");
+    MPI_Finalize();
+    return 1;
+  }
+
+  max_iters = 10;
+  if (argc > 2) sscanf(argv[2], "%d", &max_iters);
+
+  partner = my_id ^ 1;
+  buf = (int*)malloc(sizeof(int) * n);
+  reqs = (MPI_Request*)malloc(sizeof(MPI_Request) * n);
+
+  for (k = 0; k < max_iters; k++)
+  {
+    /* posted queue: receives are posted before the sends arrive */
+    MPI_Barrier(MPI_COMM_WORLD);
+    startTime = MPI_Wtime();
+    if (my_id % 2 == 0)
+    {
+      for (i = 0; i < n; i++)
+        MPI_Irecv(&buf[i], 1, MPI_INT, partner, i, MPI_COMM_WORLD, &reqs[i]);
+      MPI_Send(&n, 0, MPI_INT, partner, n, MPI_COMM_WORLD);
+      MPI_Waitall(n, reqs, MPI_STATUSES_IGNORE);
+      for (i = 0; i < n; i++)
+        if (buf[i] != i) errors++;
+    }
+    else
+    {
+      MPI_Recv(NULL, 0, MPI_INT, partner, n, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      for (i = n - 1; i >= 0; i--)
+        MPI_Send(&i, 1, MPI_INT, partner, i, MPI_COMM_WORLD);
+    }
+    postedTime += MPI_Wtime() - startTime;
+
+    /* unexpected queue: all sends arrive before the receives are posted */
+    MPI_Barrier(MPI_COMM_WORLD);
+    startTime = MPI_Wtime();
+    if (my_id % 2 == 0)
+    {
+      MPI_Recv(NULL, 0, MPI_INT, partner, n, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      for (i = n - 1; i >= 0; i--)
+        MPI_Recv(&buf[i], 1, MPI_INT, partner, i, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      for (i = 0; i < n; i++)
+        if (buf[i] != i) errors++;
+    }
+    else
+    {
+      for (i = 0; i < n; i++)
+        MPI_Send(&i, 1, MPI_INT, partner, i, MPI_COMM_WORLD);
+      MPI_Send(&n, 0, MPI_INT, partner, n, MPI_COMM_WORLD);
+    }
+    unexpectedTime += MPI_Wtime() - startTime;
+  }
+
+  MPI_Reduce(&errors, &allErrors, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+  if (my_id == 0)
+  {
+    printf("%d messages per pair, %d iterations\n", n, max_iters);
+    printf("posted queue:     %10.3f us per message\n", postedTime * 1e6 / max_iters / n);
+    printf("unexpected queue: %10.3f us per message\n", unexpectedTime * 1e6 / max_iters / n);
+    if (allErrors != 0)
+    {
+      printf("matching errors: %d\n", allErrors);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+
+  free(buf);
+  free(reqs);
+
+  MPI_Finalize();
+  return 0;
+}
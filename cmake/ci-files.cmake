@@ -82,6 +82,8 @@ foreach(in_f ${ci-files})
         set(ci-output TraceProjections.decl.h)
     elseif(${in_f} MATCHES src/ck-perf/trace-utilization.ci)
         set(ci-output TraceUtilization.decl.h)
+    elseif(${in_f} MATCHES src/ck-perf/trace-sampling.ci)
+        set(ci-output TraceSampling.decl.h)
 
     else()
         # ci filename equal to module name
@@ -1233,6 +1233,7 @@ if(CpvAccess(networkProgressCount) >=  p)  \
 #include "ckarray.h"
 #include "ckstream.h"
 #include "ckfutures.h"
+#include "ckcoroutine.h"
 #include "waitqd.h"
 #include "sdag.h"
 #include "ckcheckpoint.h"
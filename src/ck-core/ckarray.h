@@ -244,6 +244,7 @@ public:
  	using CProxy_ArrayBase::setReductionClient; //compilation error o/w
 	void setReductionClient(CkCallback *cb); 
 	void resetSection();
+	void updateSection(const std::vector<CkArrayIndex> &add, const std::vector<CkArrayIndex> &remove);
 
 	void ckSectionDelegate(CkDelegateMgr *d, int opts=1) {
            ckDelegate(d);
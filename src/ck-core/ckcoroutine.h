@@ -0,0 +1,96 @@
+#ifndef _CKCOROUTINE_H_
+#define _CKCOROUTINE_H_
+
+/**
+\addtogroup CkFutures
+
+Coroutine entry methods: a lighter alternative to [threaded] entry methods
+for code that must wait on a future.  They need a C++20 compiler; when the
+application is built with C++20 coroutine support, CMK_HAS_COROUTINES is 1.
+
+An ordinary (non-threaded) entry method whose C++ definition returns
+CkCoroutine may co_await a CkFuture, or a CkFutureID via
+CkAwaitReleaseFuture.  A suspended coroutine keeps only its frame, instead
+of a whole thread stack, and is resumed from the scheduler once the future
+is set.  The future must have been created on the awaiting PE.
+
+    .ci:  entry void run();
+    .C:   CkCoroutine run() {
+            CkFuture f = CkCreateFuture();
+            contribute(CkCallbackToFuture(f));
+            CkReductionMsg *m = (CkReductionMsg *)co_await f;
+            ...
+          }
+
+[sync] proxy calls block the calling thread, so a coroutine should use an
+[iget] entry method, whose proxy call returns a CkFutureID, instead:
+
+    ValueMsg *m = (ValueMsg *)co_await CkAwaitReleaseFuture(a[i].get());
+
+The object must not migrate while one of its coroutines is suspended.
+*/
+/*@{*/
+#if defined(__cpp_impl_coroutine) && __cplusplus > 201703L && defined(__has_include)
+#if __has_include(<coroutine>)
+#define CMK_HAS_COROUTINES 1
+#endif
+#endif
+#ifndef CMK_HAS_COROUTINES
+#define CMK_HAS_COROUTINES 0
+#endif
+
+#if CMK_HAS_COROUTINES
+#include <coroutine>
+
+/// Return type of a coroutine entry method.  Nothing waits on it: the
+/// coroutine runs until its first suspension when the entry method is
+/// invoked, and its frame is freed when it finishes.
+class CkCoroutine {
+ public:
+  struct promise_type {
+    CkCoroutine get_return_object() noexcept { return CkCoroutine(); }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept {
+      CkAbort("Unhandled exception in a coroutine entry method");
+    }
+  };
+};
+
+/// Awaiter for a local future: co_await yields the message sent to it,
+/// like CkWaitFuture (or CkWaitReleaseFuture, if constructed with release).
+class CkFutureAwaiter {
+  CkFutureID id;
+  bool release;
+
+  static void resume(void *handle) {
+    std::coroutine_handle<>::from_address(handle).resume();
+  }
+
+ public:
+  CkFutureAwaiter(CkFutureID id_, bool release_) : id(id_), release(release_) {}
+
+  bool await_ready() const { return CkProbeFutureID(id) != 0; }
+  void await_suspend(std::coroutine_handle<> h) {
+    CkCallWhenFutureReady(id, resume, h.address());
+  }
+  void *await_resume() const {
+    return release ? CkWaitReleaseFuture(id) : CkWaitFutureID(id);
+  }
+};
+
+inline CkFutureAwaiter operator co_await(CkFuture fut) {
+#if CMK_ERROR_CHECKING
+  if (fut.pe != CkMyPe()) CkAbort("co_await on a future created on another PE");
+#endif
+  return CkFutureAwaiter(fut.id, false);
+}
+
+inline CkFutureAwaiter CkAwaitReleaseFuture(CkFutureID futNum) {
+  return CkFutureAwaiter(futNum, true);
+}
+#endif /* CMK_HAS_COROUTINES */
+
+/*@}*/
+#endif
@@ -12,8 +12,9 @@ These routines are implemented in ckfutures.C.
 /*@{*/
 typedef int CkFutureID;
 typedef struct _CkFuture {
-  CkFutureID id;
-  int        pe;
+  CkFutureID   id;
+  int          pe;
+  unsigned int gen; /* generation of slot id, to catch use after release */
 } CkFuture;
 PUPbytes(CkFuture)
 
@@ -24,6 +25,8 @@ struct CkArrayID;
 extern "C" {
 #endif
 
+typedef void (*CkFutureResumeFn)(void *arg);
+
 CkFuture CkCreateFuture(void);
 void  CkSendToFuture(CkFuture fut, void *msg);
 void* CkWaitFuture(CkFuture futNum);
@@ -43,6 +46,9 @@ void CkReleaseFutureID(CkFutureID futNum);
 int CkProbeFutureID(CkFutureID futNum);
 void  CkSendToFutureID(CkFutureID futNum, void *msg, int pe);
 CkFutureID CkCreateAttachedFuture(void *msg);
+/* Call fn(arg) from the scheduler once the (local) future is set, without
+   blocking a thread.  Used to resume coroutine entry methods (ckcoroutine.h). */
+void CkCallWhenFutureReady(CkFutureID futNum, CkFutureResumeFn fn, void *arg);
 
 CkFutureID CkCreateAttachedFutureSend(void *msg, int ep, struct CkArrayID id, CkArrayIndex idx,
                           void(*fptr)(struct CkArrayID, CkArrayIndex,void*,int,int),int size CK_MSGOPTIONAL);
@@ -54,6 +60,22 @@ void _futuresModuleInit(void);
 
 #ifdef __cplusplus
 }
+
+/* A callback (e.g. a reduction client) that delivers its message to fut,
+   which must have been created on this PE. */
+CkCallback CkCallbackToFuture(CkFuture fut);
+
+/* Continuations that need no thread.  fut must be local.  Once it is set,
+   its value is sent to cb and fut is released. */
+void CkFutureThen(CkFuture fut, const CkCallback &cb);
+
+/* A new local future that is set, with a system message, once all (or any)
+   of the n local futures are set; for CkWhenAny the message's CkGetRefNum()
+   is the index of the first one.  The inputs keep their values.  They must
+   not be released before they are set, or for CkWhenAny before the new
+   future is. */
+CkFuture CkWhenAll(int n, const CkFuture *futs);
+CkFuture CkWhenAny(int n, const CkFuture *futs);
 #endif
 
 #endif
@@ -2,9 +2,14 @@
 #define _MULTICAST
 
 #include "pup.h"
+#include <map>
+#include <utility>
+#include <vector>
+
 class mCastEntry;
 
 class multicastSetupMsg;
+class multicastPatchMsg;
 class multicastGrpMsg;
 class cookieMsg;
 class CkMcastBaseMsg;
@@ -23,6 +28,11 @@ typedef void (*redClientFn)(CkSectionInfo sid, void *param,int dataSize,void *da
 extern void CkGetSectionInfo(CkSectionInfo &id, void *msg);
 
 class CProxySection_ArrayElement;
+class CProxySection_ArrayBase;
+
+/// Retrieve section info for the local member idx from the section proxy, without
+/// waiting for a multicast. Returns false if the tree does not list idx on this PE. Part of API
+extern bool CkGetSectionInfo(CkSectionInfo &id, CProxySection_ArrayBase &proxy, const CkArrayIndex &idx);
 
 /**
  * A multicast manager group that is a CkDelegateMgr. Can manage all sections of different 
@@ -35,20 +45,28 @@ class CkMulticastMgr: public CkDelegateMgr
         int dfactor;           // default spanning tree branch factor for this CkMulticastMgr, can be negative
         unsigned int split_size;
         unsigned int split_threshold;
+        /// Tree vertices on this PE, keyed by (root PE, root entry) of their section
+        std::map<std::pair<int, void *>, mCastEntryPtr> localTrees;
+        /// Roots of recently created array sections on this PE, most recently used first
+        std::vector<mCastEntryPtr> treeCache;
+        /// Whether new section proxies may reuse a cached tree (see setTreeSharing)
+        bool shareTrees;
         
     public:
         // ------------------------- Cons/Des-tructors ------------------------
-        CkMulticastMgr(CkMigrateMessage *m)  {}
+        CkMulticastMgr(CkMigrateMessage *m): shareTrees(false) {}
         CkMulticastMgr(int _dfactor = 2, unsigned int _split_size = 8192, unsigned int _split_threshold = 8192):
             dfactor(_dfactor),
             split_size(_split_size),
-            split_threshold(_split_threshold) {}
+            split_threshold(_split_threshold),
+            shareTrees(false) {}
         bool useDefCtor(void){ return true; }
         void pup(PUP::er &p){ 
 		CkDelegateMgr::pup(p);
 		p|dfactor;
 		p|split_size;
 		p|split_threshold;
+		p|shareTrees;
 	}
 
         // ------------------------- Spanning Tree Setup ------------------------
@@ -63,7 +81,7 @@ class CkMulticastMgr: public CkDelegateMgr
         /// entry Start the build of a (branch of a) spanning tree rooted at you
         void setup(multicastSetupMsg *);
         /// entry My direct children in the tree use this to tell me that they are ready
-        void recvCookie(CkSectionInfo sid, CkSectionInfo child);
+        void recvCookie(CkSectionInfo sid, CkSectionInfo child, int depth);
         /// Notify my tree parent (if any) that I am are ready
         void childrenReady(mCastEntry *entry);
         // ------------------------- Spanning Tree Teardown ------------------------
@@ -73,6 +91,14 @@ class CkMulticastMgr: public CkDelegateMgr
         void retire(CkSectionInfo s, CkSectionInfo root);
         /// entry Actually frees the old spanning tree. Propagates the call to children
         void freeup(CkSectionInfo s);
+        // ------------------------- Membership Changes ------------------------
+        /// Add and remove members of a section, patching its spanning tree in place (called by root)
+        void updateSection(CProxySection_ArrayBase &proxy, const std::vector<CkArrayIndex> &add,
+                           const std::vector<CkArrayIndex> &remove);
+        /// entry Apply a membership patch to a (branch of a) spanning tree and pass it to my children
+        void patch(multicastPatchMsg *);
+        /// entry My direct children use this to tell me that their branch is patched
+        void patchDone(CkSectionInfo sid, CkSectionInfo child, int idle, int n, char *claimed);
         // ------------------------- Section Cookie Management ------------------------
         /// entry 
         void retrieveCookie(CkSectionInfo s, CkSectionInfo srcInfo);
@@ -111,8 +137,16 @@ class CkMulticastMgr: public CkDelegateMgr
         /// @note: User should be careful while passing non-default value of fragSize. fragSize%sizeof(data_type) should be zero
 
 
+        /// Fill in the cookie of local member idx from the section cookie held by a proxy
+        bool getSectionInfo(CkSectionInfo &id, CkSectionInfo &section, const CkArrayIndex &idx);
+
         /// Recreate the section when root migrate
         void resetSection(CProxySection_ArrayBase &proxy);  // called by root
+        /// Let array section proxies delegated on this PE reuse the tree of a recent section over
+        /// the same members. Such proxies share its reductions too, so this is off by default
+        void setTreeSharing(bool share) { shareTrees = share; }
+        /// Free the trees of a section proxy once nothing is multicast or reduced over it anymore
+        void freeSection(CProxySection_ArrayBase &proxy);  // called by root
         /// Implement the CkDelegateMgr interface to accept the delegation of a section proxy
         virtual void initDelegateMgr(CProxy *proxy, int opts=0);
         /// To implement the CkDelegateMgr interface for section mcasts
@@ -136,6 +170,24 @@ class CkMulticastMgr: public CkDelegateMgr
         void sendToSection(CkDelegateData *pd,int ep,void *m, CkSectionID *sid, int opts);
         /// Mark old cookie spanning tree as old and build a new one
         void resetCookie(CkSectionInfo sid);
+        /// Record a tree vertex so that local members can find it from the section cookie
+        void registerVertex(mCastEntryPtr entry);
+        /// Forget a tree vertex that is about to be freed
+        void unregisterVertex(mCastEntryPtr entry);
+        /// Look for a live tree over exactly this member set among the recently created ones
+        mCastEntryPtr findCachedTree(CkArrayID aid, const CkArrayIndex *al, int n, int bfactor, CmiUInt8 hash);
+        /// Make a section root the most recently used entry of the tree cache
+        void cacheTree(mCastEntryPtr entry);
+        /// Build a section that shares its tree with other proxies a tree of its own
+        void unshareTree(CkSectionID &sid);
+        /// The section's current root, on a tree no other proxy shares
+        mCastEntryPtr ownTree(CkSectionID &sid);
+        /// Start patching the tree under a section root
+        void startPatch(mCastEntryPtr entry, multicastPatchMsg *msg);
+        /// Apply a patch to one vertex and forward it to its children
+        void patchVertex(mCastEntryPtr entry, multicastPatchMsg *msg);
+        /// All children of a vertex have applied the patch: report up, or finish at the root
+        void finishPatch(mCastEntryPtr entry);
         ///
         void releaseBufferedReduceMsgs(mCastEntryPtr entry);
         /// Release buffered redn msgs from later reductions which arrived early (out of order)
@@ -40,6 +40,7 @@ namespace SDAG {
 #include <vector>
 #include <list>
 #include <unordered_set>
+#include <unordered_map>
 #include <memory>
 
 #include <pup_stl.h>
@@ -178,6 +179,9 @@ namespace SDAG {
   struct Buffer : public PUP::able {
     int entry;
     Closure* cl;
+    // position in Dependency::buffer and Dependency::refBuffer, for O(1)
+    // removal; rebuilt rather than pupped
+    std::list<Buffer*>::iterator pos, refPos;
 #if USE_CRITICAL_PATH_HEADER_ARRAY
     MergeablePathHistory *savedPath;
 #endif
@@ -221,10 +225,12 @@ namespace SDAG {
     std::vector<std::list<int> > entryToWhen;
     std::vector<std::list<Continuation*> > whenToContinuation;
 
-    // entry -> lst of buffers
-    // @todo this will have sequential lookup time for specific reference
-    // numbers
+    // entry -> lst of buffers, in arrival order
     std::vector<std::list<Buffer*> > buffer;
+    // entry -> refnum -> lst of the buffers with that refnum, in arrival order
+    // (an index into buffer, not pupped)
+    typedef std::unordered_map<CMK_REFNUM_TYPE, std::list<Buffer*> > RefIndex;
+    std::vector<RefIndex> refBuffer;
 
     int curSpeculationIndex;
 
@@ -233,12 +239,14 @@ namespace SDAG {
       p | entryToWhen;
       p | buffer;
       p | whenToContinuation;
+      if (p.isUnpacking()) reindexBuffers();
     }
 
     Dependency(int numEntries, int numWhens)
       : entryToWhen(numEntries)
       , whenToContinuation(numWhens)
       , buffer(numEntries)
+      , refBuffer(numEntries)
       , curSpeculationIndex(0)
       { }
 
@@ -281,10 +289,26 @@ namespace SDAG {
 
     Buffer* pushBuffer(int entry, Closure *cl) {
       Buffer* buf = new Buffer(entry, cl);
-      buffer[entry].push_back(buf);
+      indexBuffer(buf, buffer[entry].insert(buffer[entry].end(), buf));
       return buf;
     }
 
+    void indexBuffer(Buffer *buf, std::list<Buffer*>::iterator pos) {
+      buf->pos = pos;
+      if (buf->cl->hasRefnum) {
+        std::list<Buffer*>& lst = refBuffer[buf->entry][buf->cl->refnum];
+        buf->refPos = lst.insert(lst.end(), buf);
+      }
+    }
+
+    void reindexBuffers() {
+      refBuffer.assign(buffer.size(), RefIndex());
+      for (size_t entry = 0; entry < buffer.size(); entry++)
+        for (std::list<Buffer*>::iterator iter = buffer[entry].begin();
+             iter != buffer[entry].end(); ++iter)
+          indexBuffer(*iter, iter);
+    }
+
     Continuation *tryFindContinuation(int entry) {
       for (std::list<int>::iterator iter = entryToWhen[entry].begin();
            iter != entryToWhen[entry].end();
@@ -321,12 +345,16 @@ namespace SDAG {
     }
 
     Buffer* tryFindMessage(int entry, bool hasRef, CMK_REFNUM_TYPE refnum, std::unordered_set<Buffer*>* ignore) {
-      // @todo sequential lookup for buffer with reference number or ignore set
-      for (std::list<Buffer*>::iterator iter = buffer[entry].begin();
-           iter != buffer[entry].end();
-           ++iter) {
-        if ((!hasRef || ((*iter)->cl->hasRefnum && (*iter)->cl->refnum == refnum)) &&
-            (!ignore || ignore->find(*iter) == ignore->end()))
+      std::list<Buffer*>* lst = &buffer[entry];
+      if (hasRef) {
+        RefIndex::iterator found = refBuffer[entry].find(refnum);
+        if (found == refBuffer[entry].end()) return 0;
+        lst = &found->second;
+      }
+      // only buffers already matched by this when are skipped, so the scan is
+      // as long as the ignore set at most
+      for (std::list<Buffer*>::iterator iter = lst->begin(); iter != lst->end(); ++iter) {
+        if (!ignore || ignore->find(*iter) == ignore->end())
           return *iter;
       }
       return 0;
@@ -340,7 +368,12 @@ namespace SDAG {
     }
 
     void removeMessage(Buffer *buf) {
-      buffer[buf->entry].remove(buf);
+      buffer[buf->entry].erase(buf->pos);
+      if (buf->cl->hasRefnum) {
+        RefIndex::iterator found = refBuffer[buf->entry].find(buf->cl->refnum);
+        found->second.erase(buf->refPos);
+        if (found->second.empty()) refBuffer[buf->entry].erase(found);
+      }
     }
 
     int getAndIncrementSpeculationIndex() {
@@ -73,6 +73,10 @@
 #define END_USER_EVENT_PAIR    99
 #define  USER_EVENT_PAIR    100
 
+#ifndef PROJBIN_TOOL
+/* bin/projbin2log only needs the event codes above; everything below is
+   part of the runtime. */
+
 CkpvExtern(CmiInt8, CtrLogBufSize);
 CkpvExtern(char*, traceRoot);
 CkpvExtern(char*, partitionRoot);
@@ -108,6 +112,9 @@ extern int _sdagMsg, _sdagChare, _sdagEP;
 
 /** Write out the common parts of the .sts file. */
 extern void traceWriteSTS(FILE *stsfp,int nUserEvents);
+/** Called by trace modules that stamp their own event ids into envelopes;
+    aborts if another module already does. */
+extern void traceClaimEnvelopeEvent(const char *module);
 void (*registerMachineUserEvents())();
 
 #if CMK_HAS_COUNTER_PAPI
@@ -126,6 +133,8 @@ CkpvExtern(int, numEvents);
 void initPAPI();
 #endif
 
+#endif /* PROJBIN_TOOL */
+
 #endif
 
 /*@}*/
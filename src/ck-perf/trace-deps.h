@@ -0,0 +1,122 @@
+/**
+ * \addtogroup CkPerf
+ */
+/*@{*/
+
+#ifndef _TRACE_DEPS_H
+#define _TRACE_DEPS_H
+
+#include <stdio.h>
+#include <errno.h>
+
+#ifdef DEPS_TOOL
+#include <stdint.h>
+typedef int32_t  CmiInt4;
+typedef uint32_t CmiUInt4;
+#else
+#include "charm++.h"
+#include "trace.h"
+#include "envelope.h"
+#include "register.h"
+#include "trace-common.h"
+#endif
+
+/*
+ * Records the message dependencies between entry method executions, for
+ * offline critical path analysis and what-if replay with bin/critpath.
+ *
+ * Every traced send stamps a fresh per PE event id into the envelope
+ * (the field projections also uses, so the two tracemodes can not be
+ * combined in one run), and every execution remembers the (source PE,
+ * event id) pair of the message that triggered it. Awakening a thread
+ * counts as a send to its resume. Both are logged as fixed size binary
+ * records, which keeps the per message cost at a few stores into a
+ * memory buffer.
+ *
+ * The record layout below is shared with the analysis tool, which includes
+ * this header with DEPS_TOOL defined, so it must only use fixed size types.
+ */
+
+#define DEPS_MAGIC     "CKDEPS01"
+#define DEPS_NONE      0xffffffffu
+
+#define DEPS_TASK      1   // one entry method execution
+#define DEPS_SEND      2   // one message creation (possibly multicast) or awaken
+
+/// file header of NAME.#.deps
+struct DepsHeader {
+  char magic[8];
+  CmiInt4 pe;
+  CmiInt4 numPes;
+};
+
+/// Fixed size log record. The meaning of the fields depends on kind:
+///            TASK                      SEND
+///   ep       executed entry method     destination entry method
+///   id       task id on this PE        event id stamped in the envelope
+///   srcPe    sender PE or -1           number of destinations
+///   srcEvent sender event id           id of the sending task or DEPS_NONE
+///   bytes    message size              message size
+///   t0, t1   begin and end time        send time, unused
+struct DepsRecord {
+  CmiInt4  kind;
+  CmiInt4  ep;
+  CmiUInt4 id;
+  CmiInt4  srcPe;
+  CmiUInt4 srcEvent;
+  CmiInt4  bytes;
+  double   t0;
+  double   t1;
+};
+
+#ifndef DEPS_TOOL
+
+// records buffered before the log is written out
+#define DefaultDepsBufSize 100000
+
+class TraceDeps : public Trace {
+ private:
+  FILE *fp;
+  char *logName;
+  DepsRecord *buf;
+  int bufSize;
+  int numRecords;
+
+  CmiUInt4 nextTask;
+  CmiUInt4 nextEvent;
+
+  // the execution in progress
+  bool executing;
+  int depth;
+  DepsRecord cur;
+
+  void openLog(void);
+  void flush(void);
+  inline DepsRecord &newRecord(void) {
+    if (numRecords == bufSize) flush();
+    return buf[numRecords++];
+  }
+  void begin(int ep, int srcPe, CmiUInt4 srcEvent, int mlen);
+
+ public:
+  TraceDeps(char **argv);
+  ~TraceDeps();
+
+  void creation(envelope *e, int epIdx, int num=1);
+  void creationMulticast(envelope *e, int epIdx, int num=1, const int *pelist=NULL);
+
+  void beginExecute(envelope *e, void *obj);
+  void beginExecute(CmiObjId *tid);
+  void beginExecute(int event,int msgType,int ep,int srcPe, int mlen=0, CmiObjId *idx=NULL, void *obj=NULL);
+  void endExecute(void);
+  void beginComputation(void);
+  void traceClose(void);
+
+  void writeSts(void);
+};
+
+#endif
+
+#endif
+
+/*@}*/
@@ -0,0 +1,88 @@
+/**
+ * \addtogroup CkPerf
+ */
+/*@{*/
+
+#ifndef _TRACE_PERFEVENT_H
+#define _TRACE_PERFEVENT_H
+
+#include <stdio.h>
+#include <errno.h>
+
+#include "charm++.h"
+#include "trace.h"
+#include "envelope.h"
+#include "register.h"
+#include "trace-common.h"
+
+/*
+ * Hardware counter profiles per entry method, read directly through the
+ * Linux perf_event_open system call (no PAPI required).
+ *
+ * Counters are opened as small groups of related events, so that each
+ * group fits in the PMU on its own and the kernel can multiplex groups when
+ * they do not all fit. Each reading is scaled by the fraction of time its
+ * group was actually scheduled.
+ */
+
+enum PerfEventCounter {
+  PERF_CYCLES = 0,
+  PERF_INSTRUCTIONS,
+  PERF_CACHE_REFERENCES,
+  PERF_CACHE_MISSES,
+  PERF_BRANCHES,
+  PERF_BRANCH_MISSES,
+  NUM_PERF_COUNTERS
+};
+
+#define PERF_EVENTS_PER_GROUP 2
+#define NUM_PERF_GROUPS       (NUM_PERF_COUNTERS / PERF_EVENTS_PER_GROUP)
+
+/// one group leader plus its siblings, read together
+struct PerfEventGroup {
+  int fd[PERF_EVENTS_PER_GROUP];
+  // raw values at the beginning of the current execution
+  CmiUInt8 enabled, running;
+  CmiUInt8 values[PERF_EVENTS_PER_GROUP];
+};
+
+/// accumulated (scaled) counts of one entry method or chare type
+struct PerfEventEntry {
+  CmiUInt8 calls;
+  double counts[NUM_PERF_COUNTERS];
+};
+
+class TracePerfEvent : public Trace {
+ private:
+  bool enabled;        // all counter groups could be opened
+  int execEp;
+  PerfEventGroup groups[NUM_PERF_GROUPS];
+
+  int epInfoSize;
+  PerfEventEntry *epInfo;
+
+  bool openGroups(void);
+  void closeGroups(void);
+  bool readGroup(PerfEventGroup &g, CmiUInt8 &enabled, CmiUInt8 &running, CmiUInt8 *values);
+  void begin(int ep);
+
+ public:
+  TracePerfEvent(char **argv);
+  ~TracePerfEvent();
+
+  void creation(envelope *e, int epIdx, int num=1) {}
+
+  void beginExecute(envelope *e, void *obj);
+  void beginExecute(CmiObjId *tid);
+  void beginExecute(int event,int msgType,int ep,int srcPe, int mlen=0, CmiObjId *idx=NULL, void *obj=NULL);
+  void endExecute(void);
+  void beginComputation(void);
+  void traceClose(void);
+
+  void writeSts(void);
+  void write(void);
+};
+
+#endif
+
+/*@}*/
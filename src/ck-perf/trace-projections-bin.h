@@ -0,0 +1,77 @@
+/**
+ * \addtogroup CkPerf
+ */
+/*@{*/
+
+#ifndef _TRACE_PROJECTIONS_BIN_H
+#define _TRACE_PROJECTIONS_BIN_H
+
+/*
+ * Layout of the binary Projections logs written with +binary-trace, as
+ * NAME.#.log.bin (or .log.bin.gz with +gz-trace).  bin/projbin2log turns
+ * them into the text NAME.#.log files that the Projections tool reads.
+ *
+ * A log is a ProjBinHeader followed by fixed size ProjBinRecords.  Each
+ * record holds the fields of one event; events that also carry variable
+ * length data (notes, multicast PE lists, PAPI counters) put extBytes of
+ * it into the slots following the record, padded up to whole records.
+ * Times are stored exactly as the text log prints them, in integral
+ * microseconds.
+ *
+ * The tool includes this header with PROJBIN_TOOL defined, so the layout
+ * must only use fixed size types.
+ */
+
+#ifdef PROJBIN_TOOL
+#include <stdint.h>
+typedef int32_t  CmiInt4;
+typedef uint32_t CmiUInt4;
+typedef uint16_t CmiUInt2;
+typedef uint64_t CmiUInt8;
+#endif
+
+#define PROJBIN_MAGIC   "CKPROJB1"
+#define PROJBIN_ENDIAN  0x01020304u
+
+struct ProjBinHeader {
+  char magic[8];
+  CmiUInt4 endian;      // PROJBIN_ENDIAN in the writer's byte order
+  CmiUInt4 recordSize;  // sizeof(ProjBinRecord)
+  CmiInt4 pe;
+  CmiInt4 papiEvents;   // counters appended to BEGIN/END_PROCESSING
+};
+
+/// One event.  Fields that the event type does not use are zero:
+///   time     event time (begin time of a bracketed note)
+///   time2    receive time, end time of a bracketed note, or memory usage
+///   cputime  CPU time; USER_STAT keeps its user time here as a double
+///   stat     USER_STAT value, as a double
+///   aux      nested thread ID, user supplied data, or the number of
+///            destination PEs of a broadcast or multicast
+///   ndims    index dimensions of the chare that BEGIN_PROCESSING runs
+struct ProjBinRecord {
+  CmiUInt8 time;
+  CmiUInt8 time2;
+  CmiUInt8 cputime;
+  CmiUInt8 stat;
+  CmiInt4  event;
+  CmiInt4  pe;
+  CmiInt4  msglen;
+  CmiInt4  aux;
+  CmiInt4  id[4];
+  CmiUInt4 extBytes;
+  CmiUInt2 mIdx;
+  CmiUInt2 eIdx;
+  unsigned char type;
+  signed char ndims;
+  unsigned char pad[6];
+};
+
+/// Number of record slots that \p bytes of extension data take up.
+static inline CmiUInt4 projBinExtSlots(CmiUInt4 bytes) {
+  return (bytes + sizeof(ProjBinRecord) - 1) / sizeof(ProjBinRecord);
+}
+
+#endif
+
+/*@}*/
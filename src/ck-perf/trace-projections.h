@@ -16,6 +16,7 @@
 
 #include "trace.h"
 #include "trace-common.h"
+#include "trace-projections-bin.h"
 #include "ckhashtable.h"
 
 #if CMK_USE_ZLIB
@@ -28,6 +29,16 @@
 
 #define PROJ_ANALYSIS 1
 
+// Full log buffers can be handed to a helper thread for writing (and
+// compression) instead of stalling the PE. PAPI values are PUPed through
+// per-PE state, so that configuration always flushes synchronously.
+#if !defined(_WIN32) && !CMK_HAS_COUNTER_PAPI
+#define PROJ_ASYNC_FLUSH 1
+#include <pthread.h>
+#include <signal.h>
+#include <atomic>
+#endif
+
 // Macro to make projections check for errors before an fprintf succeeds.
 #define CheckAndFPrintF(f,string,data) \
 do { \
@@ -200,6 +211,9 @@ class LogEntry {
     }
 
     void pup(PUP::er &p);
+    /// Fill the fixed size binary record for this entry (+binary-trace);
+    /// returns the number of extension bytes at \p ext that follow it.
+    unsigned int encode(ProjBinRecord &r, const void *&ext) const;
     ~LogEntry(){
     }
 };
@@ -223,6 +237,7 @@ class LogPool {
     bool hasFlushed;
     bool headerWritten;
     bool fileCreated;
+    bool asyncFlush;
 #if CMK_USE_ZLIB
     bool compressed;
 #endif
@@ -253,6 +268,38 @@ class LogPool {
     double globalStartTime; // used at the end on Pe 0 only
     double globalEndTime; // used at the end on Pe 0 only
 
+#if PROJ_ASYNC_FLUSH
+    // Double buffering for text logs with +trace-async-flush: flushPool
+    // holds the buffer currently being written by the flusher thread. Only
+    // the flusher touches the log file while a flush is pending.
+    LogEntry *flushPool;
+    unsigned int numFlushEntries;
+    bool flushPending;
+    bool flusherExit;
+    bool flusherStarted;
+    pthread_t flusher;
+    pthread_mutex_t flushLock;
+    pthread_cond_t flushCond;
+
+    // Binary logs go through a single producer, single consumer ring of
+    // fixed size records instead: the PE encodes its buffer into the ring
+    // and publishes ringHead, the flusher writes records out and publishes
+    // ringTail. flushLock and flushCond are only used to sleep when the
+    // ring is empty (flusher) or full (PE, see peWaiting).
+    ProjBinRecord *ring;
+    size_t ringSize;
+    std::atomic<size_t> ringHead;
+    std::atomic<size_t> ringTail;
+    std::atomic<bool> peWaiting;
+
+    static void *flusherLoop(void *arg);
+    void startFlusher();
+    void waitForFlusher();
+    void stopFlusher();
+    void ringPut(const void *data, size_t bytes);
+    void drainRing();
+#endif
+
     //cppcheck-suppress unsafeClassCanLeak
     bool *keepPhase;  // one decision per phase
 
@@ -279,12 +326,16 @@ class LogPool {
     long long statisTotalMemAlloc;
     long long statisTotalMemFree;
 
-    void writeHeader();
+    void writeHeader(unsigned int n);
+    bool keepEntry(const LogEntry &e, int &curPhase);
+    void writeRaw(const void *data, size_t bytes);
+    void writeBinary(LogEntry *entries, unsigned int n);
 
   public:
     LogPool(char *pgm);
     ~LogPool();
     void setBinary(int b) { binary = (b!=0); }
+    void setAsyncFlush(int a);
     void setNumSubdirs(int n) { nSubdirs = n; }
     void setWriteSummaryFiles(int n) { writeSummaryFiles = (n!=0)? true : false;}
 #if CMK_USE_ZLIB
@@ -295,8 +346,9 @@ class LogPool {
     void createRC();
     void openLog(const char *mode);
     void closeLog(void);
-    void writeLog(void);
-    void write(int writedelta);
+    void writeLog(void) { writeLog(pool, numEntries); }
+    void writeLog(LogEntry *entries, unsigned int n);
+    void write(int writedelta, LogEntry *entries, unsigned int n);
     void writeSts(void);
     void writeSts(TraceProjections *traceProj);
     void writeRC(void);
@@ -0,0 +1,122 @@
+/**
+ * \addtogroup CkPerf
+ */
+/*@{*/
+
+#ifndef _TRACE_SAMPLING_H
+#define _TRACE_SAMPLING_H
+
+#include <stdio.h>
+#include <errno.h>
+#include <vector>
+
+#include "charm++.h"
+
+#include "trace.h"
+#include "envelope.h"
+#include "register.h"
+#include "trace-common.h"
+#include "ckcallback-ccs.h"
+
+#include "TraceSampling.decl.h"
+
+#define INVALIDEP     -2
+
+/*
+ * The sampling trace mode keeps per entry method aggregates in fixed memory
+ * and only timestamps a fraction of all executions, so it is cheap enough
+ * to stay enabled for production runs.
+ *
+ * Each entry method owns SAMPLING_FIELDS doubles:
+ *   executions   - every execution of the entry method (sampled or not)
+ *   samples      - executions that were timed
+ *   bytes        - total message size of the sampled executions
+ *   time         - total time (seconds) of the sampled executions
+ *   hist[i]      - sampled executions taking [2^(i-1), 2^i) microseconds,
+ *                  hist[0] being below 1us and the last bin open ended
+ */
+#define SAMPLING_VERSION      1.0
+#define SAMPLING_HIST_BINS    20
+#define SAMPLING_FIELDS       (4 + SAMPLING_HIST_BINS)
+#define SAMPLING_EXECUTIONS   0
+#define SAMPLING_SAMPLES      1
+#define SAMPLING_BYTES        2
+#define SAMPLING_TIME         3
+#define SAMPLING_HIST         4
+
+// one in this many executions is sampled, unless +sampling-interval is given
+#define DefaultSamplingPeriod 100
+
+/* readonly */ extern CProxy_TraceSamplingBOC traceSamplingGroupProxy;
+
+/** A main chare that creates the BOC/group and registers the CCS handler */
+class TraceSamplingInit : public Chare {
+ public:
+  TraceSamplingInit(CkArgMsg *m) {
+    delete m;
+    traceSamplingGroupProxy = CProxy_TraceSamplingBOC::ckNew();
+    CcsRegisterHandler("CkPerfSampling", CkCallback(CkIndex_TraceSamplingBOC::ccsRequestSampling(NULL), traceSamplingGroupProxy[0]));
+  }
+  TraceSamplingInit(CkMigrateMessage *m):Chare(m) {}
+};
+
+
+class TraceSampling : public Trace {
+ private:
+  int period;          // sample one in every period executions (on average)
+  double interval;     // if > 0, sample the first execution every interval ms
+  int countdown;       // executions left until the next sample
+  bool armed;          // timer-driven mode: the next execution gets sampled
+
+  bool sampling;       // the current execution is being sampled
+  int execEp;
+  int execBytes;
+  double execStart;
+
+  int epInfoSize;
+  double *stats;       // epInfoSize * SAMPLING_FIELDS
+
+  void nextCountdown();
+  void begin(int ep, int mlen);
+
+ public:
+  TraceSampling(char **argv);
+  ~TraceSampling() { delete [] stats; }
+
+  static void armTimer(void *arg, double curWallTime);
+
+  void creation(envelope *e, int epIdx, int num=1) {}
+
+  void beginExecute(envelope *e, void *obj);
+  void beginExecute(CmiObjId *tid);
+  void beginExecute(int event,int msgType,int ep,int srcPe, int mlen=0, CmiObjId *idx=NULL, void *obj=NULL);
+  void endExecute(void);
+  void beginComputation(void);
+  void endComputation(void) {}
+  void traceClose(void);
+
+  int getEpInfoSize() const { return epInfoSize; }
+  const double *getStats() const { return stats; }
+
+  void writeSts(void);
+  void write(void);
+};
+
+
+class TraceSamplingBOC : public CBase_TraceSamplingBOC {
+  // CCS requests waiting for the reduction that is in flight
+  std::vector<CcsDelayedReply> pendingReplies;
+
+ public:
+  TraceSamplingBOC() {}
+  TraceSamplingBOC(CkMigrateMessage* msg) {}
+
+  /// Entry methods:
+  void ccsRequestSampling(CkCcsRequestMsg *m);
+  void collectSamplingData();
+  void samplingDataCollected(CkReductionMsg *);
+};
+
+#endif
+
+/*@}*/
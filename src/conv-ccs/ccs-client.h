@@ -33,6 +33,7 @@ typedef struct CcsServer {
 
   /*Current State:*/
   SOCKET replyFd;/*Socket for replies*/
+  SOCKET pipeFd;/*Persistent socket for pipelined requests*/
 } CcsServer;
 
 /*All routines return -1 on failure*/
@@ -56,6 +57,14 @@ int CcsSendMulticastRequest(CcsServer *svr, const char *hdlrID, int npes,
 int CcsSendMulticastRequestWithTimeout(CcsServer *svr, const char *hdlrID, int npes, 
             int *pes, int size, const void *msg, int timeout);
 
+/*Pipelined requests share one persistent connection, and need not
+wait for each other's replies; each reply comes back with the tag
+of its request.  Not available with authentication.*/
+int CcsSendPipelinedRequest(CcsServer *svr, const char *hdlrID, int pe,
+            int size, const void *msg, int tag);
+int CcsRecvPipelinedResponse(CcsServer *svr,
+            int *tag, int *retSize, void **newBuf, int timeout);
+
 int CcsNoResponse(CcsServer *svr);
 int CcsRecvResponse(CcsServer *svr, 
 		    int maxsize, void *recvBuffer, int timeout);
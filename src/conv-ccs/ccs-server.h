@@ -44,6 +44,7 @@ typedef struct {
   char handler[CCS_MAXHANDLER];/*Handler name for message to follow*/
   ChMessageInt_t pe;/*Dest. processor # (global numbering)*/
   ChMessageInt_t replyFd;/*Send reply back here*/
+  ChMessageInt_t replyTag;/*Tag of a pipelined request; -1 for others*/
   ChMessageInt_t len;/*Bytes of message data to follow*/
 } CcsImplHeader;
 
@@ -68,21 +69,29 @@ Returns the actual port and IP address.
 */
 void CcsServer_new(skt_ip_t *ret_ip,int *use_port,const char *securityFile);
 
+/*Close the server and all its connections.*/
+void CcsServer_close(void);
+
 /*Get the Ccs Server socket.  This socket can
-be added to the rdfs list for calling select().
+be added to the rdfs list for calling select(); it
+becomes readable when there are new connections,
+requests, or replies waiting to be written.
 */
 SOCKET CcsServer_fd(void);
 
-/*Connect to the Ccs Server socket, and 
-receive a ccs request from the network.
+/*Receive the next ccs request from the network, accepting
+new connections and writing out queued replies on the way.
 Returns 1 if a request was successfully received;
-0 otherwise.
+0 once there is nothing left to do, so call it until it
+returns 0 whenever CcsServer_fd() is readable.
 reqData is allocated with malloc(hdr->len).
 */
 int CcsServer_recvRequest(CcsImplHeader *hdr,void **reqData);
 
 /*Send a Ccs reply down the given socket.
-Closes the socket afterwards.
+Closes the socket afterwards, unless the request was
+pipelined: then the reply is queued on its connection,
+and written out by the next CcsServer_recvRequest.
 */
 void CcsServer_sendReply(CcsImplHeader *hdr,int repBytes,const void *repData);
 
@@ -94,6 +103,7 @@ void CcsServer_noReply(CcsImplHeader *hdr);
 #else /*CCS not available*/
 
 #define CcsServer_new(i,p) /*empty*/
+#define CcsServer_close() /*empty*/
 #define CcsServer_fd() SOCKET_ERROR
 #define CcsServer_recvReq(h,b) 0
 #define CcsServer_sendReply(f,l,d) /*empty*/
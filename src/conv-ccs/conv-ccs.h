@@ -83,6 +83,10 @@ SIMPLE_POLYMORPH_REDUCTION(min);
 
 void CcsReleaseMessages();
 void CcsInit(char **argv);
+#if NODE_0_IS_CONVHOST && CMK_SMP
+/*Polls the CCS server; called by the communication thread of node 0*/
+void CcsServerCommThreadCheck(void);
+#endif
 int CcsEnabled(void);
 int CcsIsRemoteRequest(void);
 void CcsCallerId(skt_ip_t *pip, unsigned int *pport);
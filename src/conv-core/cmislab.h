@@ -0,0 +1,38 @@
+/* Size class slab allocator for CmiAlloc'd message buffers */
+#ifndef CMISLAB_H
+#define CMISLAB_H
+
+#include "converse.h"
+
+/* Every block starts with this many bytes of allocator header, which keeps
+   the CmiChunkHeader that follows it ALIGN_BYTES aligned. */
+#define CMI_SLAB_HEADER_SIZE 16
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* Statistics of the calling thread's cache */
+typedef struct {
+  CmiUInt8 allocs;        /* allocations served by a size class */
+  CmiUInt8 hits;          /* allocations served from the free lists */
+  CmiUInt8 largeAllocs;   /* allocations too large for a size class */
+  CmiUInt8 remoteFrees;   /* blocks freed here but owned by another thread */
+  CmiUInt8 remoteBatches; /* batches sent back to their owners */
+  CmiUInt8 returned;      /* blocks other threads gave back to this cache */
+  CmiUInt8 slabBytes;     /* memory carved into slabs by this cache */
+  CmiUInt8 inUseBytes;    /* slab memory currently handed out */
+} CmiSlabStats;
+
+void  CmiSlabInit(char **argv);
+void *CmiSlabAlloc(size_t numBytes);
+void  CmiSlabFree(void *p);
+void  CmiSlabFlush(void);
+void  CmiSlabGetStats(CmiSlabStats *stats);
+void  CmiSlabPrintStats(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CMISLAB_H */
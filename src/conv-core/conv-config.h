@@ -127,6 +127,11 @@
 #define CMI_QD (CMK_REPLAYSYSTEM)
 #endif
 
+/* Size class slab allocator behind CmiAlloc, see cmislab.C */
+#ifndef CMK_MSG_SLAB
+#define CMK_MSG_SLAB 1
+#endif
+
 #ifndef CMI_SWAPGLOBALS
 #define CMI_SWAPGLOBALS (CMK_HAS_ELF_H && !CMK_SMP)
 #endif
@@ -1582,6 +1582,7 @@ int        CthIsSuspendable(CthThread);
 // For debugging
 void	   CthPrintThdMagic(CthThread); 
 void 	   CthPrintThdStack(CthThread);
+void       CthPrintStackStats(void);
 
 void       CthSuspend(void);
 void       CthAwaken(CthThread);
@@ -682,6 +682,22 @@ typedef void (*MPI_MigrateFn)(void);
 #define  MPI_Ineighbor_allgatherv  AMPI_Ineighbor_allgatherv
 #define PMPI_Ineighbor_allgatherv APMPI_Ineighbor_allgatherv
 
+/***persistent collectives***/
+#define  MPI_Barrier_init  AMPI_Barrier_init
+#define PMPI_Barrier_init APMPI_Barrier_init
+#define  MPI_Bcast_init  AMPI_Bcast_init
+#define PMPI_Bcast_init APMPI_Bcast_init
+#define  MPI_Reduce_init  AMPI_Reduce_init
+#define PMPI_Reduce_init APMPI_Reduce_init
+#define  MPI_Allreduce_init  AMPI_Allreduce_init
+#define PMPI_Allreduce_init APMPI_Allreduce_init
+#define  MPI_Alltoall_init  AMPI_Alltoall_init
+#define PMPI_Alltoall_init APMPI_Alltoall_init
+#define  MPI_Neighbor_alltoall_init  AMPI_Neighbor_alltoall_init
+#define PMPI_Neighbor_alltoall_init APMPI_Neighbor_alltoall_init
+#define  MPI_Neighbor_allgather_init  AMPI_Neighbor_allgather_init
+#define PMPI_Neighbor_allgather_init APMPI_Neighbor_allgather_init
+
 /***ops***/
 #define  MPI_Op_create  AMPI_Op_create
 #define PMPI_Op_create APMPI_Op_create
@@ -330,6 +330,24 @@ AMPI_FUNC(int, MPI_Ineighbor_allgatherv, const void* sendbuf, int sendcount, MPI
                               void* recvbuf, const int* recvcounts, const int* displs, MPI_Datatype recvtype,
                               MPI_Comm comm, MPI_Request *request)
 
+/***persistent collectives***/
+AMPI_FUNC(int, MPI_Barrier_init, MPI_Comm comm, MPI_Info info, MPI_Request *request)
+AMPI_FUNC(int, MPI_Bcast_init, void *buf, int count, MPI_Datatype type, int root, MPI_Comm comm,
+                MPI_Info info, MPI_Request *request)
+AMPI_FUNC(int, MPI_Reduce_init, const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+                 MPI_Op op, int root, MPI_Comm comm, MPI_Info info, MPI_Request *request)
+AMPI_FUNC(int, MPI_Allreduce_init, const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+                    MPI_Op op, MPI_Comm comm, MPI_Info info, MPI_Request *request)
+AMPI_FUNC(int, MPI_Alltoall_init, const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                   void *recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm,
+                   MPI_Info info, MPI_Request *request)
+AMPI_FUNC(int, MPI_Neighbor_alltoall_init, const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                            void* recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm,
+                            MPI_Info info, MPI_Request* request)
+AMPI_FUNC(int, MPI_Neighbor_allgather_init, const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                             void* recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm,
+                             MPI_Info info, MPI_Request* request)
+
 /***ops***/
 AMPI_FUNC(int, MPI_Op_create, MPI_User_function *function, int commute, MPI_Op *op)
 AMPI_FUNC(int, MPI_Op_free, MPI_Op *op)
@@ -473,6 +491,9 @@ AMPI_CUSTOM_FUNC(int, MPI_WIN_DUP_FN         , MPI_Win, int, void *, void *, voi
 AMPI_FUNC(int, MPI_Win_create, void *base, MPI_Aint size, int disp_unit,
                     MPI_Info info, MPI_Comm comm, MPI_Win *newwin)
 AMPI_FUNC(int, MPI_Win_allocate, MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm, void *baseptr, MPI_Win *win)
+AMPI_FUNC(int, MPI_Win_allocate_shared, MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm, void *baseptr, MPI_Win *win)
+AMPI_FUNC(int, MPI_Win_shared_query, MPI_Win win, int rank, MPI_Aint *size, int *disp_unit, void *baseptr)
+AMPI_FUNC(int, MPI_Win_sync, MPI_Win win)
 AMPI_FUNC(int, MPI_Win_free, MPI_Win *win)
 AMPI_FUNC(int, MPI_Win_create_errhandler, MPI_Win_errhandler_function *win_errhandler_fn,
                                MPI_Errhandler *errhandler)
@@ -677,7 +698,6 @@ AMPI_FUNC_NOIMPL(int, MPI_Unpublish_name, const char *service_name, MPI_Info inf
 
 /* A.2.9 One-Sided Communications C Bindings */
 
-AMPI_FUNC_NOIMPL(int, MPI_Win_allocate_shared, MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm, void *baseptr, MPI_Win *win)
 AMPI_FUNC_NOIMPL(int, MPI_Win_attach, MPI_Win win, void *base, MPI_Aint size)
 AMPI_FUNC_NOIMPL(int, MPI_Win_create_dynamic, MPI_Info info, MPI_Comm comm, MPI_Win *win)
 AMPI_FUNC_NOIMPL(int, MPI_Win_detach, MPI_Win win, const void *base)
@@ -685,8 +705,6 @@ AMPI_FUNC_NOIMPL(int, MPI_Win_flush, int rank, MPI_Win win)
 AMPI_FUNC_NOIMPL(int, MPI_Win_flush_all, MPI_Win win)
 AMPI_FUNC_NOIMPL(int, MPI_Win_flush_local, int rank, MPI_Win win)
 AMPI_FUNC_NOIMPL(int, MPI_Win_flush_local_all, MPI_Win win)
-AMPI_FUNC_NOIMPL(int, MPI_Win_shared_query, MPI_Win win, int rank, MPI_Aint *size, int *disp_unit, void *baseptr)
-AMPI_FUNC_NOIMPL(int, MPI_Win_sync, MPI_Win win)
 
 
 /* A.2.10 External Interfaces C Bindings */
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <numeric>
 #include <bitset>
+#include <unordered_map>
 #include <complex>
 #include <iostream>
 
@@ -196,11 +197,27 @@ extern int AMPI_RDMA_THRESHOLD;
 #define AMPI_ALLTOALL_SHORT_MSG  256
 #define AMPI_ALLTOALL_LONG_MSG   32768
 
+/* If nonzero, blocking collectives on communicators with more than one rank
+ * per process combine through shared memory before leaving the process. */
+#ifndef AMPI_NODE_LOCAL_COLL_DEFAULT
+#define AMPI_NODE_LOCAL_COLL_DEFAULT 0
+#endif
+
+extern int AMPI_NODE_LOCAL_COLL;
+void ampiLocalCollNodeInit() noexcept;
+
 typedef void (*MPI_MigrateFn)(void);
 
 /*
  * AMPI Message Matching (Amm) Interface:
  * messages are matched on 2 ints: [tag, src]
+ *
+ * Entries are kept in one list in arrival order. Once a queue holds more
+ * than AMPI_AMM_HASH_THRESHOLD entries, entries with a concrete [tag, src]
+ * are also indexed in per-[tag, src] FIFO bins, and entries containing a
+ * wildcard go on a separate list, so that a lookup for a concrete
+ * [tag, src] only compares the front of one bin against the wildcard list.
+ * Lookups containing a wildcard still scan the arrival-order list.
  */
 #define AMM_TAG   0
 #define AMM_SRC   1
@@ -216,6 +233,11 @@ typedef void (*MPI_MigrateFn)(void);
 #define AMPI_AMM_COLL_POOL_SIZE 4
 #endif
 
+// Number of entries above which an Amm indexes its entries by [tag, src]:
+#ifndef AMPI_AMM_HASH_THRESHOLD
+#define AMPI_AMM_HASH_THRESHOLD 16
+#endif
+
 class AmpiRequestList;
 
 typedef void (*AmmPupMessageFn)(PUP::er& p, void **msg);
@@ -225,11 +247,33 @@ class AmmEntry {
  public:
   int tags[AMM_NTAGS]; // [tag, src]
   AmmEntry<T>* next;
+  AmmEntry<T>** prevh; // address of the pointer to this entry in arrival order
+  AmmEntry<T>* binNext; // next entry in the same bin (or wildcard list)
+  CmiUInt8 seq; // arrival order, used to pick between a bin and the wildcard list
   T msg; // T is either an AmpiRequest* or an AmpiMsg*
-  AmmEntry(T m) noexcept { tags[AMM_TAG] = m->getTag(); tags[AMM_SRC] = m->getSrcRank(); next = NULL; msg = m; }
-  AmmEntry(int tag, int src, T m) noexcept { tags[AMM_TAG] = tag; tags[AMM_SRC] = src; next = NULL; msg = m; }
+  AmmEntry(T m) noexcept { tags[AMM_TAG] = m->getTag(); tags[AMM_SRC] = m->getSrcRank(); next = NULL; binNext = NULL; msg = m; }
+  AmmEntry(int tag, int src, T m) noexcept { tags[AMM_TAG] = tag; tags[AMM_SRC] = src; next = NULL; binNext = NULL; msg = m; }
   AmmEntry() = default;
   ~AmmEntry() = default;
+  inline bool hasWildcard() const noexcept {
+    return (tags[AMM_TAG] == MPI_ANY_TAG || tags[AMM_SRC] == MPI_ANY_SOURCE);
+  }
+};
+
+// FIFO of AmmEntry's linked through binNext:
+template <class T>
+class AmmBin {
+ public:
+  AmmEntry<T>* head;
+  AmmEntry<T>** tailh;
+  AmmBin() noexcept : head(NULL), tailh(&head) {}
+  AmmBin(const AmmBin&) = delete; // tailh may point at head
+  inline void push(AmmEntry<T>* e) noexcept { e->binNext = NULL; *tailh = e; tailh = &e->binNext; }
+  inline void remove(AmmEntry<T>** eh) noexcept {
+    AmmEntry<T>* e = *eh;
+    *eh = e->binNext;
+    if (!*eh) tailh = eh;
+  }
 };
 
 template <class T, size_t N>
@@ -243,8 +287,27 @@ class Amm {
   std::bitset<N> validEntries;
   std::array<AmmEntry<T>, N> entryPool;
 
+  int count;
+  CmiUInt8 nextSeq;
+  bool hashed; // are bins and wildBin valid?
+  std::unordered_map<CmiUInt8, AmmBin<T>> bins; // entries with a concrete [tag, src]
+  AmmBin<T> wildBin; // entries with MPI_ANY_TAG and/or MPI_ANY_SOURCE
+
+  static inline CmiUInt8 binKey(int tag, int src) noexcept {
+    return ((CmiUInt8)(CmiUInt4)tag << 32) | (CmiUInt4)src;
+  }
+  inline void index(AmmEntry<T>* e) noexcept {
+    if (e->hasWildcard()) wildBin.push(e);
+    else bins[binKey(e->tags[AMM_TAG], e->tags[AMM_SRC])].push(e);
+  }
+  void buildIndex() noexcept;
+  void clearIndex() noexcept;
+  inline void link(AmmEntry<T>* e) noexcept;
+  inline void unlink(AmmEntry<T>* e) noexcept;
+  inline AmmEntry<T>* find(int tag, int src) noexcept;
+
  public:
-  Amm() noexcept : first(NULL), lasth(&first), startIdx(0) { validEntries.reset();  }
+  Amm() noexcept : first(NULL), lasth(&first), startIdx(0), count(0), nextSeq(0), hashed(false) { validEntries.reset();  }
   ~Amm() = default;
   inline AmmEntry<T>* newEntry(int tag, int src, T msg) noexcept {
     if (validEntries.all()) {
@@ -429,6 +492,19 @@ class lockQueueEntry {
 typedef CkQ<lockQueueEntry *> LockQueue;
 
 class ampiParent;
+class win_obj;
+
+// Where one rank's window memory lives, exchanged when the window is created
+struct AmpiWinPeer {
+  char* base;
+  MPI_Aint size; // in bytes
+  int disp_unit;
+  int node;      // CkMyNode(): ranks in the same process can use loads/stores
+  int physNode;  // CmiPhysicalNodeID(): ranks on the same host can use CMA
+  int pid;
+  win_obj* obj;  // only valid within the same process
+};
+PUPbytes(AmpiWinPeer) // addresses are only meant to be used within the same process
 
 class win_obj {
  public:
@@ -437,6 +513,17 @@ class win_obj {
   int disp_unit;
   MPI_Comm comm;
 
+  // Serializes accumulates from origins that access this window directly
+  CmiNodeLock accLock;
+  std::vector<AmpiWinPeer> peers; // indexed by rank in comm, empty if unknown, only pup'ed if isShared
+  int peersEpoch; // ampiParent::migrateEpoch when peers was gathered
+  bool isShared;  // created by MPI_Win_allocate_shared
+  bool useCma;
+  char* shmBase;  // MPI_Win_allocate_shared segment, if this rank maps/owns it
+  size_t shmSize;
+  bool shmMapped; // shmBase is an mmap rather than a malloc_nomigrate
+  int shmNode;    // process of a shared window's ranks, which they cannot leave
+
   int owner; // Rank of owner of the lock, -1 if not locked
   LockQueue lockQueue; // queue of waiting processors for the lock
                        // top of queue is the one holding the lock
@@ -470,6 +557,13 @@ class win_obj {
   int accumulate(void *orgaddr, int count, MPI_Aint targdisp, MPI_Datatype targtype,
                  MPI_Op op, ampiParent* pptr) noexcept;
 
+  void gatherPeers(MPI_Comm comm) noexcept;
+  void refreshPeers(MPI_Comm comm) noexcept;
+  bool inProcess(int rank, ampiParent* pptr) const noexcept;
+  bool isDirect(int rank, ampiParent* pptr) const noexcept;
+  bool isCma(int rank, ampiParent* pptr) const noexcept;
+  char* peerAddr(int rank, MPI_Aint targdisp, int bytes) const noexcept;
+
   int iget(int orgcnt, MPI_Datatype orgtype,
           MPI_Aint targdisp, int targcnt, MPI_Datatype targtype) noexcept;
   int igetWait(MPI_Request *req, MPI_Status *status) noexcept;
@@ -1137,6 +1231,7 @@ inline std::vector<int> rangeExclOp(int n, int ranges[][3], const std::vector<in
 #define MPI_RMA_TAG         MPI_TAG_UB_VALUE+10
 #define MPI_EPOCH_START_TAG MPI_TAG_UB_VALUE+11
 #define MPI_EPOCH_END_TAG   MPI_TAG_UB_VALUE+12
+#define MPI_BARR_TAG        MPI_TAG_UB_VALUE+13
 
 #define AMPI_COLL_SOURCE 0
 #define AMPI_COLL_COMM   MPI_COMM_WORLD
@@ -1151,8 +1246,9 @@ enum AmpiReqType : uint8_t {
   AMPI_GATHER_REQ  = 6,
   AMPI_GATHERV_REQ = 7,
   AMPI_G_REQ       = 8,
+  AMPI_PCOLL_REQ   = 9,
 #if CMK_CUDA
-  AMPI_GPU_REQ     = 9
+  AMPI_GPU_REQ     = 10
 #endif
 };
 
@@ -1244,7 +1340,7 @@ class AmpiRequest {
   }
 
   /// Set whether the request is currently blocked on
-  void setBlocked(bool b) noexcept { blocked = b; }
+  virtual void setBlocked(bool b) noexcept { blocked = b; }
   bool isBlocked() const noexcept { return blocked; }
 
   /// Returns the type of request:
@@ -1595,6 +1691,69 @@ class ATAReq final : public AmpiRequest {
   void print() const noexcept override;
 };
 
+enum AmpiPersCollKind : uint8_t {
+  AMPI_PCOLL_SCHEDULE  = 0, // a fixed set of persistent point-to-point requests
+  AMPI_PCOLL_BARRIER   = 1,
+  AMPI_PCOLL_BCAST     = 2,
+  AMPI_PCOLL_REDUCE    = 3,
+  AMPI_PCOLL_ALLREDUCE = 4
+};
+
+// A persistent collective (MPI_*_init). Everything that depends only on the
+// arguments is worked out once, at init time: exchange-style collectives keep
+// one persistent IReq/SendReq per peer with its buffer offset and datatype
+// already resolved, and reductions keep their reducer type and callback.
+// MPI_Start then only replays the schedule.
+class PersCollReq final : public AmpiRequest {
+ public:
+  AmpiPersCollKind kind = AMPI_PCOLL_SCHEDULE;
+  const void* sendbuf   = nullptr;
+  MPI_Op op             = MPI_OP_NULL;
+  int root              = 0;
+  int reducer           = 0; // CkReduction::reducerType, or invalid if not builtin
+  CkCallback rednCB;
+  std::vector<MPI_Request> schedule; // persistent sub-requests, receives first
+  MPI_Request inner = MPI_REQUEST_NULL; // in-flight collective for the other kinds
+
+  PersCollReq(AmpiPersCollKind kind_, const void* sendbuf_, void* buf_, int count_, MPI_Datatype type_,
+              MPI_Op op_, int root_, MPI_Comm comm_, CkDDT* ddt_, AmpiReqSts sts_=AMPI_REQ_COMPLETED) noexcept
+    : kind(kind_), sendbuf(sendbuf_), op(op_), root(root_)
+  {
+    buf   = buf_;
+    count = count_;
+    type  = type_;
+    src   = AMPI_COLL_SOURCE;
+    tag   = MPI_ATA_TAG;
+    comm  = comm_;
+    AMPI_REQUEST_COMMON_INIT
+  }
+  PersCollReq() =default;
+  ~PersCollReq() =default;
+  void start(MPI_Request reqIdx) noexcept override;
+  bool test(MPI_Status *sts=MPI_STATUS_IGNORE) noexcept override;
+  CMI_WARN_UNUSED_RESULT ampiParent* wait(ampiParent* parent, MPI_Status *sts, int* result=nullptr) noexcept override;
+  bool receive(ampi *ptr, AmpiMsg *msg, bool deleteMsg=true) noexcept override { return true; }
+  void receive(ampi *ptr, CkReductionMsg *msg) noexcept override {}
+  bool isPersistent() const noexcept override { return true; }
+  AmpiReqType getType() const noexcept override { return AMPI_PCOLL_REQ; }
+  bool isUnmatched() const noexcept override { return false; }
+  // Only the sub-requests complete, so they must wake up a blocked wait
+  void setBlocked(bool b) noexcept override;
+  void freeSubReqs(AmpiRequestList& reqList, CkDDT* ddt) noexcept;
+  void pup(PUP::er &p) noexcept override {
+    AmpiRequest::pup(p);
+    p|kind;
+    p((char *)&sendbuf, sizeof(void *)); //supposed to work only with Isomalloc
+    p|op;
+    p|root;
+    p|reducer;
+    p|rednCB;
+    p|schedule;
+    p|inner;
+  }
+  void print() const noexcept override;
+};
+
 class GReq final : public AmpiRequest {
  private:
   MPI_Grequest_query_function* queryFn;
@@ -2084,6 +2243,10 @@ class ampiParent final : public CBase_ampiParent {
  public: // Communication state:
   int numBlockedReqs; // number of requests currently blocked on
   bool resumeOnRecv, resumeOnColl;
+  int migrateEpoch; // bumped by AMPI_Migrate and by every migration of this rank,
+                    // to invalidate cached rank locations
+  int placementEpoch; // bumped by AMPI_Migrate and by restarts, after which any
+                      // rank may be in another process
   AmpiRequestList ampiReqs;
   AmpiRequestPool reqPool;
   AmpiRequest *blockingReq;
@@ -2555,6 +2718,49 @@ public:
   }
 };
 
+/*
+Placement of a communicator's ranks in processes, used by the node-local
+collectives in ampiLocalColl.C. The lowest rank in each process leads it,
+and the leaders of all processes form leaderComm. The layout moves with
+the rank, and is rebuilt after ampiParent::placementEpoch changes.
+*/
+struct AmpiLocalCollSlot;
+struct AmpiLocalCollEntry;
+
+class AmpiLocalCollTopo {
+ public:
+  int epoch = -1;
+  int seq = 0;              // number of node-local collectives since (re)building
+  bool enabled = false;     // true if some process holds more than one rank
+  bool building = false;
+  bool done = false;        // set by the leader once a non-leader may return
+  int waitSeq = -1;         // seq of the collective this rank is suspended in
+  int myLeader = 0;         // leaderComm rank of this process's leader
+  int localIdx = 0;         // index of this rank in localRanks
+  std::vector<int> localRanks;  // ranks in this process, ascending
+  std::vector<int> rankLeader;  // leaderComm rank of each rank's leader
+  std::vector<int> leaderRanks; // all ranks grouped by leader, ascending within a group
+  std::vector<int> leaderDispl; // start of each leader's group in leaderRanks
+  MPI_Comm leaderComm = MPI_COMM_NULL;
+
+  inline int numLeaders() const noexcept { return (int)leaderDispl.size() - 1; }
+  inline int groupSize(int leader) const noexcept { return leaderDispl[leader+1] - leaderDispl[leader]; }
+  void pup(PUP::er &p) noexcept {
+    // Ranks are only packed between collectives, so building, done and
+    // waitSeq always have their initial values here
+    p|epoch;
+    p|seq;
+    p|enabled;
+    p|myLeader;
+    p|localIdx;
+    p|localRanks;
+    p|rankLeader;
+    p|leaderRanks;
+    p|leaderDispl;
+    p|leaderComm;
+  }
+};
+
 /*
 An ampi manages the communication of one thread over
 one MPI communicator.
@@ -2595,6 +2801,7 @@ class ampi final : public CBase_ampi {
   std::vector<int> tmpVec; // stores temp group info
   CProxy_ampi remoteProxy; // valid only for intercommunicator
   CkPupPtrVec<win_obj> winObjects;
+  AmpiLocalCollTopo localColl;
 
  private:
   inline bool isInOrder(int seqIdx, int seq) noexcept { return oorder.isInOrder(seqIdx, seq); }
@@ -2797,7 +3004,10 @@ class ampi final : public CBase_ampi {
   inline int getIndexForRank(int r) const noexcept {return myComm.getIndexForRank(r);}
   inline int getIndexForRemoteRank(int r) const noexcept {return myComm.getIndexForRemoteRank(r);}
   void findNeighbors(MPI_Comm comm, int rank, std::vector<int>& neighbors) const noexcept;
-  inline const std::vector<int>& getNeighbors() const noexcept { return myComm.getTopologyforNeighbors()->getnbors(); }
+  // The topology lives in ampiParent's copy of the comm struct, not in myComm
+  inline const std::vector<int>& getNeighbors() const noexcept {
+    return parent->comm2CommStruct(myComm.getComm()).getTopologyforNeighbors()->getnbors();
+  }
   inline bool opIsCommutative(MPI_Op op) const noexcept { return parent->opIsCommutative(op); }
   inline MPI_User_function* op2User_function(MPI_Op op) const noexcept { return parent->op2User_function(op); }
   void topoDup(int topoType, int rank, MPI_Comm comm, MPI_Comm *newcomm) noexcept;
@@ -2806,6 +3016,28 @@ class ampi final : public CBase_ampi {
   CkDDT *getDDT() noexcept {return &parent->myDDT;}
   CthThread getThread() const noexcept { return thread->getThread(); }
 
+ public: // node-local collectives, see ampiLocalColl.C
+  bool useNodeLocalColl() noexcept;
+  void localCollWake(int seq) noexcept;
+  CMI_WARN_UNUSED_RESULT ampi* localBcast(int root, void* buf, int count, MPI_Datatype type) noexcept;
+  CMI_WARN_UNUSED_RESULT ampi* localAllreduce(const void* inbuf, void* outbuf, int count,
+                                              MPI_Datatype type, MPI_Op op) noexcept;
+  CMI_WARN_UNUSED_RESULT ampi* localReduceScatter(const void* sendbuf, void* recvbuf, const int* recvcounts,
+                                                  MPI_Datatype type, MPI_Op op) noexcept;
+  CMI_WARN_UNUSED_RESULT ampi* localAllgather(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                                              void* recvbuf, int recvcount, MPI_Datatype recvtype) noexcept;
+  CMI_WARN_UNUSED_RESULT ampi* localAlltoall(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
+                                             void* recvbuf, int recvcount, MPI_Datatype recvtype) noexcept;
+
+ private:
+  void buildLocalCollTopo() noexcept;
+  AmpiLocalCollSlot* localCollArrive(const AmpiLocalCollEntry& entry) noexcept;
+  void localCollReduce(std::vector<AmpiLocalCollEntry>& entries, int count, MPI_Datatype type,
+                       MPI_Op op, std::vector<char>& result) noexcept;
+  void localCollRelease(AmpiLocalCollSlot* slot) noexcept;
+  void localCollWait(int seq) noexcept;
+  void wakeLocalRank(const AmpiLocalCollEntry& e, int rank, int seq) noexcept;
+
  public:
   MPI_Win createWinInstance(void *base, MPI_Aint size, int disp_unit, MPI_Info info) noexcept;
   int deleteWinInstance(MPI_Win win) noexcept;
@@ -2877,6 +3109,8 @@ void checkComm(MPI_Comm comm) noexcept;
 void checkRequest(MPI_Request req) noexcept;
 void handle_MPI_BOTTOM(void* &buf, MPI_Datatype type) noexcept;
 void handle_MPI_BOTTOM(void* &buf1, MPI_Datatype type1, void* &buf2, MPI_Datatype type2) noexcept;
+int copyDatatype(MPI_Datatype sendtype, int sendcount, MPI_Datatype recvtype,
+                 int recvcount, const void *inbuf, void *outbuf) noexcept;
 
 #if AMPI_ERROR_CHECKING
 int ampiErrhandler(const char* func, int errcode) noexcept;
@@ -2889,9 +3123,9 @@ int ampiErrhandler(const char* func, int errcode) noexcept;
 
 // List of AMPI functions to trace:
 static const char *funclist[] = {"AMPI_Abort", "AMPI_Add_error_class", "AMPI_Add_error_code", "AMPI_Add_error_string",
-"AMPI_Address", "AMPI_Allgather", "AMPI_Allgatherv", "AMPI_Allreduce", "AMPI_Alltoall",
+"AMPI_Address", "AMPI_Allgather", "AMPI_Allgatherv", "AMPI_Allreduce", "AMPI_Allreduce_init", "AMPI_Alltoall", "AMPI_Alltoall_init",
 "AMPI_Alltoallv", "AMPI_Alltoallw", "AMPI_Attr_delete", "AMPI_Attr_get",
-"AMPI_Attr_put", "AMPI_Barrier", "AMPI_Bcast", "AMPI_Bsend", "AMPI_Cancel",
+"AMPI_Attr_put", "AMPI_Barrier", "AMPI_Barrier_init", "AMPI_Bcast", "AMPI_Bcast_init", "AMPI_Bsend", "AMPI_Cancel",
 "AMPI_Cart_coords", "AMPI_Cart_create", "AMPI_Cart_get", "AMPI_Cart_map",
 "AMPI_Cart_rank", "AMPI_Cart_shift", "AMPI_Cart_sub", "AMPI_Cartdim_get",
 "AMPI_Comm_call_errhandler", "AMPI_Comm_compare", "AMPI_Comm_create", "AMPI_Comm_create_group",
@@ -2919,10 +3153,10 @@ static const char *funclist[] = {"AMPI_Abort", "AMPI_Add_error_class", "AMPI_Add
 "AMPI_Ineighbor_alltoallw", "AMPI_Init", "AMPI_Init_thread", "AMPI_Initialized", "AMPI_Intercomm_create",
 "AMPI_Intercomm_merge", "AMPI_Iprobe", "AMPI_Irecv", "AMPI_Ireduce", "AMPI_Ireduce_scatter",
 "AMPI_Ireduce_scatter_block", "AMPI_Is_thread_main", "AMPI_Iscan", "AMPI_Iscatter", "AMPI_Iscatterv",
-"AMPI_Isend", "AMPI_Issend", "AMPI_Keyval_create", "AMPI_Keyval_free", "AMPI_Neighbor_allgather",
-"AMPI_Neighbor_allgatherv", "AMPI_Neighbor_alltoall", "AMPI_Neighbor_alltoallv", "AMPI_Neighbor_alltoallw",
+"AMPI_Isend", "AMPI_Issend", "AMPI_Keyval_create", "AMPI_Keyval_free", "AMPI_Neighbor_allgather", "AMPI_Neighbor_allgather_init",
+"AMPI_Neighbor_allgatherv", "AMPI_Neighbor_alltoall", "AMPI_Neighbor_alltoall_init", "AMPI_Neighbor_alltoallv", "AMPI_Neighbor_alltoallw",
 "AMPI_Op_commutative", "AMPI_Op_create", "AMPI_Op_free", "AMPI_Pack", "AMPI_Pack_size",
-"AMPI_Pcontrol", "AMPI_Probe", "AMPI_Query_thread", "AMPI_Recv", "AMPI_Recv_init", "AMPI_Reduce",
+"AMPI_Pcontrol", "AMPI_Probe", "AMPI_Query_thread", "AMPI_Recv", "AMPI_Recv_init", "AMPI_Reduce", "AMPI_Reduce_init",
 "AMPI_Reduce_local", "AMPI_Reduce_scatter", "AMPI_Reduce_scatter_block", "AMPI_Request_free",
 "AMPI_Request_get_status", "AMPI_Rsend", "AMPI_Scan", "AMPI_Scatter", "AMPI_Scatterv", "AMPI_Send",
 "AMPI_Send_init",  "AMPI_Sendrecv", "AMPI_Sendrecv_replace", "AMPI_Ssend", "AMPI_Ssend_init",
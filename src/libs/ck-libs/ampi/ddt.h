@@ -63,6 +63,83 @@ inline void serializeContig(char* userdata, char* buffer, size_t size, CkDDT_Dir
   }
 }
 
+/* Serialize blocks of N bytes spaced stride bytes apart.
+ * A constant N lets the compiler turn each memcpy into plain loads and stores. */
+template <size_t N>
+inline void serializeStridedBlocks(char* userdata, char* buffer, MPI_Aint stride, size_t blocks,
+                                   CkDDT_Dir dir) noexcept
+{
+  if (dir == PACK) {
+    for (size_t i=0; i<blocks; i++) {
+      memcpy(buffer + i*N, userdata + i*stride, N);
+    }
+  }
+  else {
+    for (size_t i=0; i<blocks; i++) {
+      memcpy(userdata + i*stride, buffer + i*N, N);
+    }
+  }
+}
+
+/* Serialize count blocks of blockSize bytes spaced stride bytes apart,
+ * stopping after msgLength bytes. Returns the number of bytes copied. */
+inline size_t serializeStrided(char* userdata, char* buffer, size_t blockSize, MPI_Aint stride,
+                               size_t count, size_t msgLength, CkDDT_Dir dir) noexcept
+{
+  if (blockSize == 0) {
+    return 0;
+  }
+  size_t blocks = std::min(count, msgLength / blockSize);
+  switch (blockSize) {
+    case 4:  serializeStridedBlocks<4>(userdata, buffer, stride, blocks, dir);  break;
+    case 8:  serializeStridedBlocks<8>(userdata, buffer, stride, blocks, dir);  break;
+    case 16: serializeStridedBlocks<16>(userdata, buffer, stride, blocks, dir); break;
+    case 24: serializeStridedBlocks<24>(userdata, buffer, stride, blocks, dir); break;
+    case 32: serializeStridedBlocks<32>(userdata, buffer, stride, blocks, dir); break;
+    default:
+      for (size_t i=0; i<blocks; i++) {
+        serializeContig(userdata + i*stride, buffer + i*blockSize, blockSize, dir);
+      }
+  }
+  size_t bytesCopied = blocks * blockSize;
+  if (blocks < count && bytesCopied < msgLength) { // partial last block
+    serializeContig(userdata + blocks*stride, buffer + bytesCopied, msgLength - bytesCopied, dir);
+    bytesCopied = msgLength;
+  }
+  return bytesCopied;
+}
+
+/*
+ * A contiguous run of bytes in a datatype's typemap, relative to the
+ * start of the user's buffer. Datatypes that flatten into a bounded
+ * number of segments can be copied directly between two non-contiguous
+ * layouts, without packing into an intermediate buffer.
+ */
+struct CkDDT_Segment {
+  MPI_Aint disp;
+  size_t length;
+};
+
+#define CkDDT_MAX_SEGMENTS (1 << 16)
+
+/* Append a segment, merging it with the previous one when they touch.
+ * Returns false once there are too many segments to be worth flattening. */
+inline bool CkDDT_AddSegment(std::vector<CkDDT_Segment>& segs, MPI_Aint disp, size_t length) noexcept
+{
+  if (length == 0) {
+    return true;
+  }
+  if (!segs.empty() && segs.back().disp + (MPI_Aint)segs.back().length == disp) {
+    segs.back().length += length;
+    return true;
+  }
+  if (segs.size() == CkDDT_MAX_SEGMENTS) {
+    return false;
+  }
+  segs.push_back({disp, length});
+  return true;
+}
+
 /* Helper function to set names (used by AMPI too).
  * Leading whitespaces are significant, trailing spaces are not. */
 inline void CkDDT_SetName(std::string &dst, const char *src) noexcept
@@ -109,6 +186,9 @@ class CkDDT;
  *
  * baseType - pointer to the base datatype
  * name - user specified name for datatype
+ * segments - flattened segments of one element, computed once by commit()
+ * segmentsKnown, tooFragmented - whether segments is filled in, or the type
+ *                                has too many segments to be flattened
  */
 class CkDDT_DataType
 {
@@ -131,6 +211,9 @@ class CkDDT_DataType
   CkDDT_DataType *baseType;
   std::unordered_map<int, uintptr_t> attributes;
   std::string name;
+  mutable std::vector<CkDDT_Segment> segments;
+  mutable bool segmentsKnown = false;
+  mutable bool tooFragmented = false;
 
  public:
   CkDDT_DataType() = default;
@@ -170,6 +253,32 @@ class CkDDT_DataType
     }
   }
   virtual int getNumBasicElements(int bytes) const noexcept;
+  /* Append the segments of num consecutive elements starting at disp,
+   * in serialization order. Returns false if the type can't be flattened. */
+  virtual bool flatten(std::vector<CkDDT_Segment>& segs, MPI_Aint disp, int num) const noexcept
+  {
+    if (iscontig) {
+      return CkDDT_AddSegment(segs, disp, (size_t)num * (size_t)size);
+    }
+    for (int i=0; i<num; i++) {
+      if (!CkDDT_AddSegment(segs, disp + i*extent, size)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /* Flatten the type once, so direct copies don't redo it on every call.
+   * Types are immutable, so the result stays valid until the type is freed. */
+  void commit() const noexcept;
+  /* The segments of one element, or NULL if the type is too fragmented or
+   * has been used with MPI_BOTTOM since it was committed. */
+  const std::vector<CkDDT_Segment>* getSegments() const noexcept {
+    if (!segmentsKnown) {
+      commit();
+    }
+    return (tooFragmented || isAbsolute) ? NULL : &segments;
+  }
 
   void setSize(MPI_Aint lb, MPI_Aint extent) noexcept;
   bool isContig() const noexcept { return iscontig; }
@@ -229,6 +338,7 @@ class CkDDT_Contiguous final : public CkDDT_DataType
   CkDDT_Contiguous(const CkDDT_Contiguous& obj, MPI_Aint _lb, MPI_Aint _extent) noexcept;
 
   size_t serialize(char* userdata, char* buffer, int num, int msgLength, CkDDT_Dir dir) const noexcept override;
+  bool flatten(std::vector<CkDDT_Segment>& segs, MPI_Aint disp, int num) const noexcept override;
   void pupType(PUP::er &p, CkDDT* ddt) noexcept override;
   virtual void pup(PUP::er &p) noexcept override;
   int getEnvelope(int *ni, int *na, int *nd, int *combiner) const noexcept override;
@@ -257,6 +367,7 @@ class CkDDT_Vector : public CkDDT_DataType
   CkDDT_Vector(const CkDDT_Vector &obj, MPI_Aint _lb, MPI_Aint _extent) noexcept;
 
   size_t serialize(char* userdata, char* buffer, int num, int msgLength, CkDDT_Dir dir) const noexcept override;
+  bool flatten(std::vector<CkDDT_Segment>& segs, MPI_Aint disp, int num) const noexcept override;
   void pupType(PUP::er &p, CkDDT* ddt) noexcept override;
   virtual void pup(PUP::er &p) noexcept override;
   int getEnvelope(int *ni, int *na, int *nd, int *combiner) const noexcept override;
@@ -283,6 +394,7 @@ class CkDDT_HVector final : public CkDDT_Vector
   CkDDT_HVector(const CkDDT_HVector &obj, MPI_Aint _lb, MPI_Aint _extent) noexcept;
 
   size_t serialize(char* userdata, char* buffer, int num, int msgLength, CkDDT_Dir dir) const noexcept override;
+  bool flatten(std::vector<CkDDT_Segment>& segs, MPI_Aint disp, int num) const noexcept override;
   void pupType(PUP::er &p, CkDDT* ddt) noexcept override;
   virtual void pup(PUP::er &p) noexcept override;
   int getEnvelope(int *ni, int *na, int *nd, int *combiner) const noexcept override;
@@ -319,6 +431,7 @@ class CkDDT_HIndexed_Block : public CkDDT_DataType
   CkDDT_HIndexed_Block(const CkDDT_HIndexed_Block &obj, MPI_Aint _lb, MPI_Aint _extent) noexcept;
 
   size_t serialize(char *userdata, char *buffer, int num, int msgLength, CkDDT_Dir dir) const noexcept override;
+  bool flatten(std::vector<CkDDT_Segment>& segs, MPI_Aint disp, int num) const noexcept override;
   void pupType(PUP::er &p, CkDDT *ddt) noexcept override;
   virtual void pup(PUP::er &p) noexcept override;
   int getEnvelope(int *ni, int *na, int *nd, int *combiner) const noexcept override;
@@ -347,6 +460,7 @@ class CkDDT_Indexed_Block final : public CkDDT_HIndexed_Block
   CkDDT_Indexed_Block(const CkDDT_Indexed_Block &obj, MPI_Aint _lb, MPI_Aint _extent) noexcept;
 
   size_t serialize(char *userdata, char *buffer, int num, int msgLength, CkDDT_Dir dir) const noexcept override;
+  bool flatten(std::vector<CkDDT_Segment>& segs, MPI_Aint disp, int num) const noexcept override;
   void pupType(PUP::er &p, CkDDT *ddt) noexcept override;
   virtual void pup(PUP::er &p) noexcept override;
   int getEnvelope(int *ni, int *na, int *nd, int *combiner) const noexcept override;
@@ -378,6 +492,7 @@ class CkDDT_HIndexed : public CkDDT_DataType
   CkDDT_HIndexed(const CkDDT_HIndexed &obj, MPI_Aint _lb, MPI_Aint _extent) noexcept;
 
   size_t serialize(char* userdata, char* buffer, int num, int msgLength, CkDDT_Dir dir) const noexcept override;
+  bool flatten(std::vector<CkDDT_Segment>& segs, MPI_Aint disp, int num) const noexcept override;
   void pupType(PUP::er &p, CkDDT* ddt) noexcept override;
   virtual void pup(PUP::er &p) noexcept override;
   int getEnvelope(int *ni, int *na, int *nd, int *combiner) const noexcept override;
@@ -404,6 +519,7 @@ class CkDDT_Indexed final : public CkDDT_HIndexed
   CkDDT_Indexed(const CkDDT_Indexed &obj, MPI_Aint _lb, MPI_Aint _extent) noexcept;
 
   size_t serialize(char* userdata, char* buffer, int num, int msgLength, CkDDT_Dir dir) const noexcept override;
+  bool flatten(std::vector<CkDDT_Segment>& segs, MPI_Aint disp, int num) const noexcept override;
   void pupType(PUP::er &p, CkDDT* ddt) noexcept override;
   virtual void pup(PUP::er &p) noexcept override;
   int getEnvelope(int *ni, int *na, int *nd, int *combiner) const noexcept override;
@@ -443,6 +559,7 @@ class CkDDT_Struct final : public CkDDT_DataType
   const std::vector<CkDDT_DataType *>& getBaseTypes() const noexcept { return arrayDataType; }
 
   size_t serialize(char* userdata, char* buffer, int num, int msgLength, CkDDT_Dir dir) const noexcept override;
+  bool flatten(std::vector<CkDDT_Segment>& segs, MPI_Aint disp, int num) const noexcept override;
   void pupType(PUP::er &p, CkDDT* ddt) noexcept override;
   virtual void pup(PUP::er &p) noexcept override;
   int getEnvelope(int *ni, int *na, int *nd, int *combiner) const noexcept override;
@@ -451,6 +568,12 @@ class CkDDT_Struct final : public CkDDT_DataType
   std::string getTypeMap() const noexcept override;
 };
 
+/* Copy up to maxLength bytes from one datatype layout to another without
+ * an intermediate buffer. Returns false, having copied nothing, if either
+ * type can't be flattened. */
+bool CkDDT_CopyDirect(const CkDDT_DataType* sddt, const char* sbuf, int scount,
+                      const CkDDT_DataType* rddt, char* rbuf, int rcount, size_t maxLength) noexcept;
+
 /*
  * This class maintains the table of all datatypes (predefined and user-defined).
  *
@@ -477,6 +600,8 @@ class CkDDT
     CkAssert(type <= AMPI_MAX_BASIC_TYPE);
     CkAssert(type <= AMPI_MAX_PREDEFINED_TYPE);
     predefinedTypeTable_[type] = new CkDDT_DataType(type);
+    // Predefined types are shared by all ranks, so never flatten them lazily
+    predefinedTypeTable_[type]->commit();
   }
 
   static
@@ -490,6 +615,7 @@ class CkDDT
     CkDDT_DataType* nTypes[2]  = {const_cast<CkDDT_DataType *>(predefinedTypeTable_[val]), const_cast<CkDDT_DataType *>(predefinedTypeTable_[idx])};
     MPI_Aint offsets[2]        = {0, offset};
     predefinedTypeTable_[type] = new CkDDT_Struct(2, bLengths, offsets, bTypes, nTypes, name);
+    predefinedTypeTable_[type]->commit();
   }
 
   static
@@ -0,0 +1,122 @@
+#ifndef __CKSHAREDREPLICA_H__
+#define __CKSHAREDREPLICA_H__
+
+#include <vector>
+#include <unordered_map>
+#include "charm++.h"
+
+/**
+Shared replicas: large immutable data (material tables, stencils, ...)
+that many array elements on a process carry identically.
+
+The bytes live once per logical node in the CkSharedReplicaManager
+nodegroup, keyed by a 64-bit content hash; each element holds a
+reference-counted CkSharedReplica handle to them.  Registering bytes
+that are already present on the node just takes another reference.
+
+Replicas are told apart by their length, the 64-bit FNV-1a hash and an
+independent 64-bit check.  Registering bytes compares them with the
+node's copy, but a migrating handle only brings the digest along, so
+two different replicas of the same length are assumed never to agree
+on both hashes.  Replicas that share the FNV-1a hash but differ in the
+check or the length abort.
+
+When an element migrates, its handles pup only the digest, the length
+and the sending node.  The receiving node attaches to its own copy if it
+has one, and otherwise fetches the bytes once from the sender, which
+keeps them alive until then and until the zero copy transfer of them
+completes.  A handle unpacked this way may not be ready
+yet: wait for it with whenReady() before calling data().  Every other
+kind of pup (checkpoints, marshalled parameters) carries the bytes.
+
+Link with -module CkSharedReplica.
+*/
+
+/// Per-node record of one replica.  Internal to CkSharedReplicaManager.
+struct CkSharedReplicaEntry {
+  CmiUInt8 hash;
+  CmiUInt8 check;
+  size_t len;
+  std::vector<char> data;
+  /// Handles on this node, migrations in flight that may fetch it and
+  /// transfers to other nodes still reading it.
+  int refs;
+  bool ready;
+  std::vector<CkCallback> waiters;
+  std::vector<int> requesters;
+
+  CkSharedReplicaEntry(CmiUInt8 h, CmiUInt8 c, size_t l)
+    : hash(h), check(c), len(l), refs(0), ready(false) { }
+};
+
+class CkSharedReplica {
+  CkSharedReplicaEntry *entry;
+
+ public:
+  CkSharedReplica() : entry(NULL) { }
+  /// Register a copy of \p len bytes at \p data, or share the node's copy.
+  CkSharedReplica(const void *data, size_t len);
+  template <class T>
+  explicit CkSharedReplica(const std::vector<T> &v)
+    : CkSharedReplica(v.data(), v.size() * sizeof(T)) { }
+  CkSharedReplica(const CkSharedReplica &other);
+  CkSharedReplica(CkSharedReplica &&other) : entry(other.entry) { other.entry = NULL; }
+  CkSharedReplica &operator=(const CkSharedReplica &other);
+  CkSharedReplica &operator=(CkSharedReplica &&other);
+  ~CkSharedReplica();
+
+  bool isEmpty() const { return entry == NULL; }
+  bool isReady() const;
+  /// Send \p cb once the bytes are present on this node (at once if they are).
+  void whenReady(const CkCallback &cb) const;
+
+  /// The shared bytes, or NULL while the handle is empty or not ready.
+  const void *data() const { return isReady() ? entry->data.data() : NULL; }
+  template <class T> const T *as() const { return (const T *)data(); }
+  size_t size() const { return entry ? entry->len : 0; }
+  CmiUInt8 hash() const { return entry ? entry->hash : 0; }
+
+  void pup(PUP::er &p);
+};
+
+#include "CkSharedReplica.decl.h"
+
+extern CProxy_CkSharedReplicaManager _sharedReplicaManager;
+
+class CkSharedReplicaInit : public CBase_CkSharedReplicaInit {
+ public:
+  CkSharedReplicaInit(CkArgMsg *m);
+};
+
+class CkSharedReplicaManager : public CBase_CkSharedReplicaManager {
+  std::unordered_map<CmiUInt8, CkSharedReplicaEntry *> replicas;
+  CmiNodeLock lock;
+
+  void fill(CkSharedReplicaEntry *e, const char *data, std::vector<CkCallback> &cbs,
+            std::vector<int> &reqs);
+  void serve(CkSharedReplicaEntry *e, const std::vector<int> &reqs);
+  void releaseLocked(CkSharedReplicaEntry *e);
+
+ public:
+  CkSharedReplicaManager();
+  CkSharedReplicaManager(CkMigrateMessage *m) : CBase_CkSharedReplicaManager(m) { }
+  ~CkSharedReplicaManager();
+
+  static CkSharedReplicaManager *local() { return _sharedReplicaManager.ckLocalBranch(); }
+
+  // Called by CkSharedReplica on any PE of this node.
+  CkSharedReplicaEntry *insert(const void *data, size_t len);
+  CkSharedReplicaEntry *attach(CmiUInt8 hash, CmiUInt8 check, size_t len, int srcNode);
+  void retain(CkSharedReplicaEntry *e);
+  void release(CkSharedReplicaEntry *e);
+  bool isReady(CkSharedReplicaEntry *e);
+  void whenReady(CkSharedReplicaEntry *e, const CkCallback &cb);
+
+  // Between the nodes of a migration.
+  void fetch(CmiUInt8 hash, int requester);
+  void deliver(CmiUInt8 hash, CmiUInt8 check, size_t len, char *data);
+  void sent(CkDataMsg *m);
+  void unpin(CmiUInt8 hash);
+};
+
+#endif
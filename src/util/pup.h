@@ -55,6 +55,7 @@ class bar {
 #define __CK_PUP_H
 
 #include <stdio.h> /*<- for "FILE *" */
+#include <string.h> /*<- for memcpy */
 #include <type_traits>
 #include <utility>
 #include <functional>
@@ -197,8 +198,29 @@ class er {
   er(const er &p);//You don't want to copy PUP::er's.
  protected:
    unsigned int PUP_er_state;
+ private:
+  /// Which plain PUP::er this is, so that bytesDirect can skip the
+  /// virtual bytes() call. Found on first use by resolveDirectKind.
+  unsigned char directKind;
+  /// Where bytesDirect counts or copies to, set by resolveDirectKind.
+  /// Reaching the subclass's fields through these rather than a downcast
+  /// keeps the inlined code valid for every PUP::er it is compiled into.
+  union {
+    size_t *count;   // DIRECT_SIZER: the sizer's byte count
+    myByte **cursor; // DIRECT_TOMEM, DIRECT_FROMMEM: the buffer position
+  } direct;
+  void resolveDirectKind(void);
+ protected:
    // You don't want to create raw PUP::er's.
-   explicit er(unsigned int inType) : PUP_er_state(inType) {}
+   explicit er(unsigned int inType) : PUP_er_state(inType), directKind(DIRECT_UNKNOWN) {}
+
+   enum {
+     DIRECT_UNKNOWN = 0,
+     DIRECT_NONE, // Some other PUP::er, or an overridden bytes(): always call bytes()
+     DIRECT_SIZER,
+     DIRECT_TOMEM,
+     DIRECT_FROMMEM
+   };
 
    /// These state bits describe the PUP::er's direction.
    enum
@@ -258,9 +280,16 @@ class er {
   //For arrays:
   template<class T>
   void operator()(T *a,size_t nItems) {
-    bytes((void *)a,nItems, sizeof(T), getXlateDataType(a));
+    if (!bytesDirect((void *)a,nItems*sizeof(T)))
+      bytes((void *)a,nItems, sizeof(T), getXlateDataType(a));
   }
 
+  /// Inline fast path for PUP::sizer, PUP::toMem and PUP::fromMem (but not
+  /// their subclasses): count or copy nBytes without a virtual call, so a
+  /// scalar becomes a single load/store. Returns false if bytes() must be
+  /// called instead.
+  inline bool bytesDirect(void *p,size_t nBytes);
+
   // Standard pup_buffer API that calls malloc for allocation on isUnpacking and free for deallocation on isPacking
   template<class T>
   void pup_buffer(T *&a, size_t nItems) {
@@ -383,6 +412,7 @@ enum {
 /************** PUP::er -- Sizer ******************/
 //For finding the number of bytes to pack (e.g., to preallocate a memory buffer)
 class sizer : public er {
+  friend class er;
  protected:
   size_t nBytes;
   //Generic bottleneck: n items of size itemSize
@@ -409,6 +439,7 @@ inline size_t size(T &t) {
 
 /********** PUP::er -- Binary memory buffer pack/unpack *********/
 class mem : public er { //Memory-buffer packers and unpackers
+  friend class er;
  protected:
   myByte *origBuf;//Start of memory buffer
   myByte *buf;//Memory buffer (stuff gets packed into/out of here)
@@ -495,6 +526,25 @@ inline void fromMemBuf(T &t,void *buf,size_t len) {
 		"This means your pup routine doesn't match during packing and unpacking");
 }
 
+inline bool er::bytesDirect(void *p,size_t nBytes) {
+  if (directKind==DIRECT_UNKNOWN) resolveDirectKind();
+  switch (directKind) {
+  case DIRECT_SIZER:
+    *direct.count+=nBytes;
+    return true;
+  case DIRECT_TOMEM:
+    memcpy((void *)*direct.cursor,p,nBytes);
+    *direct.cursor+=nBytes;
+    return true;
+  case DIRECT_FROMMEM:
+    memcpy(p,(const void *)*direct.cursor,nBytes);
+    *direct.cursor+=nBytes;
+    return true;
+  default:
+    return false;
+  }
+}
+
 /********** PUP::er -- Binary disk file pack/unpack *********/
 class disk : public er {
  protected:
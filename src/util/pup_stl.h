@@ -422,6 +422,31 @@ using Requires = typename requires_impl<
     pup(p, a);
   }
 
+  /// std::array and std::complex of raw-byte types are laid out as plain
+  /// arrays of their element type, so arrays of them (including the storage
+  /// of a std::vector) pack as one block of elements.
+  template <class T, std::size_t N>
+  class as_bytes<std::array<T, N>> {
+  public:
+    enum {value = as_bytes<T>::value && sizeof(std::array<T, N>) == N * sizeof(T)};
+  };
+  template <class T>
+  class as_bytes<std::complex<T>> {
+  public:
+    enum {value = as_bytes<T>::value};
+  };
+
+  template <typename T, std::size_t N,
+            Requires<PUP::as_bytes<std::array<T, N>>::value> = nullptr>
+  inline void PUParray(er& p, std::array<T, N>* ta, size_t n) {
+    PUParray(p, reinterpret_cast<T*>(ta), n * N);
+  }
+
+  template <class T, Requires<PUP::as_bytes<T>::value> = nullptr>
+  inline void PUParray(er& p, std::complex<T>* ta, size_t n) {
+    PUParray(p, reinterpret_cast<T*>(ta), 2 * n);
+  }
+
   template <typename T, Requires<std::is_enum<T>::value> = nullptr>
   inline void operator|(PUP::er& p, T& s) {
     pup_bytes(&p, static_cast<void*>(&s), sizeof(T));
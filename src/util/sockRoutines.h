@@ -279,6 +279,7 @@ typedef struct {
 
 #define ChInitNodetabFields 2
 #define ChInitNodeforkFields 2
+#define ChInitNodeforktreeFields 3 /*nodefork, plus the fanout of the fork tree*/
 
 typedef struct {
   ChMessageInt_t nodeno;
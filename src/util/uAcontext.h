@@ -0,0 +1,232 @@
+#ifndef CMK_ACONTEXT_H
+#define CMK_ACONTEXT_H
+
+/*
+  Minimal hand-written context switch for x86-64 SysV and AArch64.
+
+  A context is just a saved stack pointer.  Switching pushes the
+  callee-saved registers onto the current stack, stores the stack
+  pointer, loads the new one and pops the new thread's registers; the
+  compiler already treats the call as clobbering everything else.  No
+  signal mask is saved (unlike ucontext) and no transfer record is
+  passed around (unlike boost-context).
+
+  The floating point control state (MXCSR and the x87 control word,
+  or FPCR) is saved as well, unless CMK_THREADS_ACONTEXT_NOFPU is set.
+  Skipping it is safe as long as no thread changes rounding modes or
+  exception masks.  The AArch64 callee-saved d8-d15 are always saved.
+
+  The TLS pointer (%fs or TPIDR_EL0) is not touched here: switching
+  TLS segments stays with CmiTLSSegmentSet, which the thread
+  interception hooks already call around every switch.
+*/
+
+#if !(defined(__x86_64__) || defined(__aarch64__)) || defined(_WIN32)
+#error "uAcontext threads are only available on x86-64 and AArch64 Unix"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef CMK_THREADS_ACONTEXT_NOFPU
+#define CMK_THREADS_ACONTEXT_NOFPU 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct uAcontext_stack_t {
+  void *ss_sp;
+  int ss_flags;
+  size_t ss_size;
+} uAcontext_stack_t;
+
+typedef struct uAcontext_t {
+  void *sp;                    /* saved stack pointer, NULL before makeJcontext */
+  uAcontext_stack_t uc_stack;
+  struct uAcontext_t *uc_link; /* unused, kept for the ucontext interface */
+} uAcontext_t;
+
+typedef void (*uAcontext_fn_t)(void *, void *);
+
+void CthAsmSwitch(void **from_sp, void *to_sp);
+void CthAsmTrampoline(void);
+
+#ifdef __APPLE__
+#define CTH_ASM_SYM(name) "_" #name
+#define CTH_ASM_FUNC(name) ".private_extern " CTH_ASM_SYM(name) "\n" \
+                           ".globl " CTH_ASM_SYM(name) "\n" CTH_ASM_SYM(name) ":\n"
+#define CTH_ASM_END(name)
+#else
+#define CTH_ASM_SYM(name) #name
+#define CTH_ASM_FUNC(name) ".globl " #name "\n.hidden " #name "\n" \
+                           ".type " #name ",%function\n" #name ":\n"
+#define CTH_ASM_END(name) ".size " #name ",.-" #name "\n"
+#endif
+
+#if defined(__x86_64__)
+
+/* frame: [mxcsr, x87 cw] r15 r14 r13 r12 rbx rbp return-address */
+#if CMK_THREADS_ACONTEXT_NOFPU
+#define CTH_ASM_FPU_SAVE
+#define CTH_ASM_FPU_LOAD
+#define CTH_ASM_FPU_WORDS 0
+#else
+#define CTH_ASM_FPU_SAVE "subq $8, %rsp\n stmxcsr (%rsp)\n fnstcw 4(%rsp)\n"
+#define CTH_ASM_FPU_LOAD "ldmxcsr (%rsp)\n fldcw 4(%rsp)\n addq $8, %rsp\n"
+#define CTH_ASM_FPU_WORDS 1
+#endif
+#define CTH_ASM_FRAME_WORDS (7 + CTH_ASM_FPU_WORDS)
+
+__asm__(
+  ".text\n"
+  ".p2align 4\n"
+  CTH_ASM_FUNC(CthAsmSwitch)
+  "pushq %rbp\n pushq %rbx\n pushq %r12\n pushq %r13\n pushq %r14\n pushq %r15\n"
+  CTH_ASM_FPU_SAVE
+  "movq %rsp, (%rdi)\n"
+  "movq %rsi, %rsp\n"
+  CTH_ASM_FPU_LOAD
+  "popq %r15\n popq %r14\n popq %r13\n popq %r12\n popq %rbx\n popq %rbp\n"
+  "ret\n"
+  CTH_ASM_END(CthAsmSwitch)
+  /* first switch into a new thread returns here: call r12(r13, r14) */
+  ".p2align 4\n"
+  CTH_ASM_FUNC(CthAsmTrampoline)
+  "movq %r13, %rdi\n"
+  "movq %r14, %rsi\n"
+  "andq $-16, %rsp\n"
+  "call *%r12\n"
+  "ud2\n"
+  CTH_ASM_END(CthAsmTrampoline)
+);
+
+static inline void CthAsmInitFrame(void **frame, uAcontext_fn_t fn, void *a1, void *a2)
+{
+  int i = 0;
+#if !CMK_THREADS_ACONTEXT_NOFPU
+  /* new threads start with the creator's floating point control state */
+  unsigned int fpu[2] = {0, 0};
+  __asm__ __volatile__("stmxcsr %0\n fnstcw %1" : "=m"(fpu[0]), "=m"(fpu[1]));
+  memcpy(&frame[i++], fpu, sizeof(void *));
+#endif
+  frame[i++] = NULL;          /* r15 */
+  frame[i++] = a2;            /* r14 */
+  frame[i++] = a1;            /* r13 */
+  frame[i++] = (void *)fn;    /* r12 */
+  frame[i++] = NULL;          /* rbx */
+  frame[i++] = NULL;          /* rbp, terminates backtraces */
+  frame[i++] = (void *)CthAsmTrampoline;
+}
+
+#elif defined(__aarch64__)
+
+/* frame: x19-x28, x29, x30, d8-d15, fpcr and padding */
+#if CMK_THREADS_ACONTEXT_NOFPU
+#define CTH_ASM_FPU_SAVE
+#define CTH_ASM_FPU_LOAD
+#else
+#define CTH_ASM_FPU_SAVE "mrs x9, fpcr\n str x9, [sp, #0xa0]\n"
+#define CTH_ASM_FPU_LOAD "ldr x9, [sp, #0xa0]\n msr fpcr, x9\n"
+#endif
+#define CTH_ASM_FRAME_WORDS 22
+
+__asm__(
+  ".text\n"
+  ".p2align 4\n"
+  CTH_ASM_FUNC(CthAsmSwitch)
+  "sub sp, sp, #0xb0\n"
+  "stp x19, x20, [sp, #0x00]\n"
+  "stp x21, x22, [sp, #0x10]\n"
+  "stp x23, x24, [sp, #0x20]\n"
+  "stp x25, x26, [sp, #0x30]\n"
+  "stp x27, x28, [sp, #0x40]\n"
+  "stp x29, x30, [sp, #0x50]\n"
+  "stp d8,  d9,  [sp, #0x60]\n"
+  "stp d10, d11, [sp, #0x70]\n"
+  "stp d12, d13, [sp, #0x80]\n"
+  "stp d14, d15, [sp, #0x90]\n"
+  CTH_ASM_FPU_SAVE
+  "mov x9, sp\n"
+  "str x9, [x0]\n"
+  "mov sp, x1\n"
+  CTH_ASM_FPU_LOAD
+  "ldp x19, x20, [sp, #0x00]\n"
+  "ldp x21, x22, [sp, #0x10]\n"
+  "ldp x23, x24, [sp, #0x20]\n"
+  "ldp x25, x26, [sp, #0x30]\n"
+  "ldp x27, x28, [sp, #0x40]\n"
+  "ldp x29, x30, [sp, #0x50]\n"
+  "ldp d8,  d9,  [sp, #0x60]\n"
+  "ldp d10, d11, [sp, #0x70]\n"
+  "ldp d12, d13, [sp, #0x80]\n"
+  "ldp d14, d15, [sp, #0x90]\n"
+  "add sp, sp, #0xb0\n"
+  "ret\n"
+  CTH_ASM_END(CthAsmSwitch)
+  /* first switch into a new thread returns here: call x19(x20, x21) */
+  ".p2align 4\n"
+  CTH_ASM_FUNC(CthAsmTrampoline)
+  "mov x0, x20\n"
+  "mov x1, x21\n"
+  "blr x19\n"
+  "brk #0\n"
+  CTH_ASM_END(CthAsmTrampoline)
+);
+
+static inline void CthAsmInitFrame(void **frame, uAcontext_fn_t fn, void *a1, void *a2)
+{
+  memset(frame, 0, CTH_ASM_FRAME_WORDS * sizeof(void *));
+  frame[0] = (void *)fn;                    /* x19 */
+  frame[1] = a1;                            /* x20 */
+  frame[2] = a2;                            /* x21 */
+  frame[11] = (void *)CthAsmTrampoline;     /* x30; x29 = 0 ends backtraces */
+#if !CMK_THREADS_ACONTEXT_NOFPU
+  /* new threads start with the creator's floating point control state */
+  unsigned long fpcr;
+  __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+  frame[20] = (void *)fpcr;
+#endif
+}
+
+#endif
+
+/* Same interface as the ucontext, uJcontext and uFcontext wrappers */
+static inline int getJcontext(uAcontext_t *ucp)
+{
+  ucp->sp = NULL;
+  return 0;
+}
+
+static inline int swapJcontext(uAcontext_t *oucp, const uAcontext_t *ucp)
+{
+  CthAsmSwitch(&oucp->sp, ucp->sp);
+  return 0;
+}
+
+/* Switch without coming back, e.g. away from an exiting thread */
+static inline int setJcontext(const uAcontext_t *ucp)
+{
+  void *discard;
+  CthAsmSwitch(&discard, ucp->sp);
+  return 0;
+}
+
+/* fn(a1, a2) runs on the stack in ucp->uc_stack the first time ucp is
+   switched to; fn must never return */
+static inline void makeJcontext(uAcontext_t *ucp, uAcontext_fn_t fn, int argc, void *a1, void *a2)
+{
+  (void)argc;
+  uintptr_t top = ((uintptr_t)ucp->uc_stack.ss_sp + ucp->uc_stack.ss_size) & ~(uintptr_t)15;
+  /* keep the first frame 16 byte aligned below the top of the stack */
+  void **frame = (void **)(top - ((CTH_ASM_FRAME_WORDS * sizeof(void *) + 31) & ~(uintptr_t)15));
+  CthAsmInitFrame(frame, fn, a1, a2);
+  ucp->sp = frame;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -38,6 +38,9 @@ class Parameter {
   void pupArray(XStr& str);
   void pupRdma(XStr& str, bool genRdma, bool device);
   void copyPtr(XStr& str);
+  void packFixed(XStr& str);
+  void unpackFixed(XStr& str);
+  void unpackFixedSDAGCall(XStr& str);
   void check();
   void checkPointer(Type* dt);
   void marshallArraySizes(XStr& str, Type* dt);
@@ -87,6 +90,8 @@ class Parameter {
   int isFirstRdma(void) const;
   int isFirstDeviceRdma(void) const;
   int isConditional(void) const;
+  int isFixedSize(void) const;
+  Type* getFixedSizeType(void) const;
   Type* getType(void) { return type; }
   const char* getArrayLen(void) const { return arrLen; }
   const char* getGivenName(void) const { return given_name; }
@@ -166,6 +171,8 @@ class ParamList {
   void setGivenName(const char* s);
   const char* getName(void) const;
   int isMarshalled(void) const;
+  int isFixedSize(void) const;
+  void fixedSize(XStr& str);
   int isCkArgMsgPtr(void) const;
   int isCkMigMsgPtr(void) const;
   int getNumStars(void) const;
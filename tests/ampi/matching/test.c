@@ -0,0 +1,204 @@
+/*
+  Randomized message matching: posted receives and unexpected messages,
+  mixing concrete tags with MPI_ANY_TAG and MPI_ANY_SOURCE, at queue
+  lengths below and well above the point where AMPI starts indexing its
+  matching queues by tag and source. Every match is checked against a
+  plain linear scan of the same queue, which is what MPI ordering asks for.
+
+  Rank r pairs with rank r + size/2, which sends to it. Both sides draw
+  the same pseudo-random sequence, so the receiver knows what was sent.
+  Ranks may share a process, so there is no mutable global state.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+
+#define NTAGS 8
+#define MAXLEN 1000
+#define DONE_TAG 100
+
+typedef struct {
+  int rank, size, errors;
+  unsigned int seed;
+} Ctx;
+
+typedef struct {
+  int tag, src;   /* receive spec, possibly wildcards */
+  int match;      /* index of the message it gets, or -1 */
+} Spec;
+
+static int lengths[] = { 10, 16, 17, 100, 1000 };
+
+static int rnd(Ctx *c, int n)
+{
+  c->seed = c->seed * 1103515245u + 12345u;
+  return (int)((c->seed >> 16) % (unsigned int)n);
+}
+
+static void check(Ctx *c, int cond, const char *what, int len, int i)
+{
+  if (!cond) {
+    printf("[%d] %s failed for entry %d of %d\n", c->rank, what, i, len);
+    c->errors++;
+  }
+}
+
+static int accepts(const Spec *s, int tag, int src)
+{
+  return (s->tag == MPI_ANY_TAG || s->tag == tag) && (s->src == MPI_ANY_SOURCE || s->src == src);
+}
+
+/* A spec that matches a message with this tag from src */
+static Spec randomSpec(Ctx *c, int tag, int src)
+{
+  Spec s;
+  int r = rnd(c, 6);
+  s.tag = (r == 0 || r == 2) ? MPI_ANY_TAG : tag;
+  s.src = (r == 1 || r == 2) ? MPI_ANY_SOURCE : src;
+  s.match = -1;
+  return s;
+}
+
+/*
+  Post len receives, then let the sender send len messages: each message
+  goes to the earliest posted receive that accepts it. Messages that no
+  receive accepts stay unexpected, and the sender follows up with one
+  message for each receive left over.
+*/
+static void testPosted(Ctx *c, int len, int peer, int sending)
+{
+  int tags[2*MAXLEN], got[MAXLEN];
+  Spec specs[MAXLEN];
+  MPI_Request reqs[MAXLEN];
+  MPI_Status sts[MAXLEN];
+  int matched[2*MAXLEN];
+  int src = sending ? c->rank : peer;
+  int nmsgs = len, i, j;
+
+  for (i = 0; i < len; i++) tags[i] = rnd(c, NTAGS);
+  for (i = 0; i < len; i++) specs[i] = randomSpec(c, tags[rnd(c, len)], src);
+
+  /* Linear reference: messages in order, receives in posting order */
+  for (i = 0; i < nmsgs; i++) {
+    matched[i] = -1;
+    for (j = 0; j < len; j++) {
+      if (specs[j].match < 0 && accepts(&specs[j], tags[i], src)) {
+        specs[j].match = i;
+        matched[i] = j;
+        break;
+      }
+    }
+  }
+  for (j = 0; j < len; j++) {
+    if (specs[j].match < 0) {
+      /* Every wildcard receive is taken by now, or nothing is unmatched */
+      tags[nmsgs] = specs[j].tag;
+      specs[j].match = nmsgs;
+      matched[nmsgs++] = j;
+    }
+  }
+
+  if (sending) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    for (i = 0; i < nmsgs; i++)
+      MPI_Send(&i, 1, MPI_INT, peer, tags[i], MPI_COMM_WORLD);
+    return;
+  }
+
+  for (j = 0; j < len; j++)
+    MPI_Irecv(&got[j], 1, MPI_INT, specs[j].src, specs[j].tag, MPI_COMM_WORLD, &reqs[j]);
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Waitall(len, reqs, sts);
+  for (j = 0; j < len; j++) {
+    check(c, got[j] == specs[j].match, "posted receive", len, j);
+    check(c, sts[j].MPI_TAG == tags[specs[j].match] && sts[j].MPI_SOURCE == peer,
+          "posted receive status", len, j);
+  }
+  /* Drain the messages no receive was posted for */
+  for (i = 0; i < nmsgs; i++) {
+    if (matched[i] < 0) {
+      int v;
+      MPI_Recv(&v, 1, MPI_INT, peer, tags[i], MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      check(c, v == i, "leftover message", len, i);
+    }
+  }
+}
+
+/*
+  Queue len messages before receiving any of them, then receive them in
+  a random order: each receive gets the earliest queued message it accepts.
+*/
+static void testUnexpected(Ctx *c, int len, int peer, int sending)
+{
+  int tags[MAXLEN], taken[MAXLEN];
+  int src = sending ? c->rank : peer;
+  int i, k, done;
+
+  for (i = 0; i < len; i++) tags[i] = rnd(c, NTAGS);
+
+  if (sending) {
+    for (i = 0; i < len; i++)
+      MPI_Send(&i, 1, MPI_INT, peer, tags[i], MPI_COMM_WORLD);
+    MPI_Send(&len, 1, MPI_INT, peer, DONE_TAG, MPI_COMM_WORLD);
+    return;
+  }
+
+  /* Messages from one sender arrive in order, so all are queued now */
+  MPI_Recv(&done, 1, MPI_INT, peer, DONE_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+  for (i = 0; i < len; i++) taken[i] = 0;
+  for (k = 0; k < len; k++) {
+    MPI_Status sts;
+    Spec s;
+    int v, pick = rnd(c, len), expect = -1;
+    while (taken[pick]) pick = (pick + 1) % len;
+    s = randomSpec(c, tags[pick], src);
+    for (i = 0; i < len; i++) {
+      if (!taken[i] && accepts(&s, tags[i], src)) {
+        expect = i;
+        break;
+      }
+    }
+    taken[expect] = 1;
+    MPI_Recv(&v, 1, MPI_INT, s.src, s.tag, MPI_COMM_WORLD, &sts);
+    check(c, v == expect, "unexpected message", len, k);
+    check(c, sts.MPI_TAG == tags[expect] && sts.MPI_SOURCE == peer,
+          "unexpected message status", len, k);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  Ctx c;
+  int half, peer, sending, l, total;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &c.rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &c.size);
+  c.errors = 0;
+
+  half = c.size / 2;
+  sending = (c.rank >= half);
+  peer = sending ? c.rank - half : c.rank + half;
+  if (c.rank == 2*half) peer = -1; /* odd size: sit out */
+
+  for (l = 0; l < (int)(sizeof(lengths)/sizeof(lengths[0])); l++) {
+    c.seed = 12345u + 7u * (unsigned int)lengths[l] + (unsigned int)(sending ? peer : c.rank);
+    if (peer >= 0)
+      testPosted(&c, lengths[l], peer, sending);
+    else
+      MPI_Barrier(MPI_COMM_WORLD);
+    if (peer >= 0)
+      testUnexpected(&c, lengths[l], peer, sending);
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
+  MPI_Allreduce(&c.errors, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  if (c.rank == 0) {
+    if (total == 0)
+      printf("matching test passed\n");
+    else
+      printf("matching test FAILED with %d errors\n", total);
+  }
+  MPI_Finalize();
+  return total != 0;
+}
@@ -0,0 +1,157 @@
+/*
+  Persistent collectives completed through MPI_Test, MPI_Waitany and
+  MPI_Waitsome, repeatedly restarted. Waitany and Waitsome also get a
+  point-to-point request that completes only after the collective could
+  have, so they must wake up for the collective itself.
+
+  Ranks may share a process, so there is no mutable global state.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+
+#define ITERS 20
+#define N 4
+
+typedef struct {
+  int rank, size, errors;
+} Ctx;
+
+static void check(Ctx *c, int cond, const char *what, int iter)
+{
+  if (!cond) {
+    printf("[%d] %s failed in iteration %d\n", c->rank, what, iter);
+    c->errors++;
+  }
+}
+
+/* MPI_Allreduce_init completed by polling with MPI_Test */
+static void testStartTest(Ctx *c)
+{
+  int rank = c->rank, size = c->size;
+  int in[N], out[N], i, it, flag;
+  MPI_Request req;
+  MPI_Allreduce_init(in, out, N, MPI_INT, MPI_SUM, MPI_COMM_WORLD, MPI_INFO_NULL, &req);
+  for (it = 0; it < ITERS; it++) {
+    for (i = 0; i < N; i++) in[i] = rank + i + it;
+    MPI_Start(&req);
+    flag = 0;
+    while (!flag)
+      MPI_Test(&req, &flag, MPI_STATUS_IGNORE);
+    for (i = 0; i < N; i++)
+      check(c, out[i] == size*(size-1)/2 + size*(i+it), "Allreduce_init with MPI_Test", it);
+  }
+  MPI_Request_free(&req);
+}
+
+/* Start a persistent collective and a receive whose message the right
+   neighbor only sends after leaving its own wait. */
+static void startPair(Ctx *c, MPI_Request reqs[2], int *token, int it)
+{
+  MPI_Start(&reqs[0]);
+  MPI_Irecv(token, 1, MPI_INT, (c->rank + 1) % c->size, it, MPI_COMM_WORLD, &reqs[1]);
+}
+
+static void sendToken(Ctx *c, int it)
+{
+  int left = (c->rank + c->size - 1) % c->size, token = c->rank;
+  MPI_Send(&token, 1, MPI_INT, left, it, MPI_COMM_WORLD);
+}
+
+/* MPI_Alltoall_init and MPI_Bcast_init completed with MPI_Waitany */
+static void testWaitany(Ctx *c)
+{
+  int rank = c->rank, size = c->size;
+  int *sendbuf = (int *)malloc(size * sizeof(int));
+  int *recvbuf = (int *)malloc(size * sizeof(int));
+  int bval, i, it, idx, token, done;
+  MPI_Request coll[2], reqs[2];
+  MPI_Alltoall_init(sendbuf, 1, MPI_INT, recvbuf, 1, MPI_INT, MPI_COMM_WORLD, MPI_INFO_NULL, &coll[0]);
+  MPI_Bcast_init(&bval, 1, MPI_INT, size-1, MPI_COMM_WORLD, MPI_INFO_NULL, &coll[1]);
+  for (it = 0; it < ITERS; it++) {
+    for (i = 0; i < size; i++) sendbuf[i] = rank*1000 + i + it;
+    bval = (rank == size-1) ? it*7 : -1;
+    reqs[0] = coll[it % 2];
+    startPair(c, reqs, &token, it);
+    done = 0;
+    while (done < 2) {
+      MPI_Waitany(2, reqs, &idx, MPI_STATUS_IGNORE);
+      check(c, idx == 0 || idx == 1, "Waitany index", it);
+      if (idx == 0) {
+        /* the persistent request stays valid; only the neighbor's token
+           remains, which it sends once its collective finished too */
+        reqs[0] = MPI_REQUEST_NULL;
+        sendToken(c, it);
+      } else {
+        reqs[1] = MPI_REQUEST_NULL;
+      }
+      done++;
+    }
+    check(c, token == (rank + 1) % size, "Waitany token", it);
+    if (it % 2 == 0) {
+      for (i = 0; i < size; i++)
+        check(c, recvbuf[i] == i*1000 + rank + it, "Alltoall_init with MPI_Waitany", it);
+    } else {
+      check(c, bval == it*7, "Bcast_init with MPI_Waitany", it);
+    }
+  }
+  MPI_Request_free(&coll[0]);
+  MPI_Request_free(&coll[1]);
+  free(sendbuf);
+  free(recvbuf);
+}
+
+/* MPI_Reduce_init and MPI_Barrier_init completed with MPI_Waitsome */
+static void testWaitsome(Ctx *c)
+{
+  int rank = c->rank, size = c->size;
+  int in, out, it, i, outcount, token, done;
+  int indices[2];
+  MPI_Request coll[2], reqs[2];
+  MPI_Reduce_init(&in, &out, 1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD, MPI_INFO_NULL, &coll[0]);
+  MPI_Barrier_init(MPI_COMM_WORLD, MPI_INFO_NULL, &coll[1]);
+  for (it = 0; it < ITERS; it++) {
+    in = rank * it;
+    out = -1;
+    reqs[0] = coll[it % 2];
+    startPair(c, reqs, &token, it);
+    done = 0;
+    while (done < 2) {
+      MPI_Waitsome(2, reqs, &outcount, indices, MPI_STATUSES_IGNORE);
+      check(c, outcount >= 1, "Waitsome count", it);
+      for (i = 0; i < outcount; i++) {
+        if (indices[i] == 0) sendToken(c, it);
+        reqs[indices[i]] = MPI_REQUEST_NULL;
+        done++;
+      }
+    }
+    check(c, token == (rank + 1) % size, "Waitsome token", it);
+    if (it % 2 == 0 && rank == 0)
+      check(c, out == (size-1) * it, "Reduce_init with MPI_Waitsome", it);
+  }
+  MPI_Request_free(&coll[0]);
+  MPI_Request_free(&coll[1]);
+}
+
+int main(int argc, char **argv)
+{
+  Ctx c = {0, 0, 0};
+  int total;
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &c.rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &c.size);
+
+  testStartTest(&c);
+  testWaitany(&c);
+  testWaitsome(&c);
+
+  MPI_Allreduce(&c.errors, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  if (c.rank == 0) {
+    if (total == 0)
+      printf("perscoll test passed\n");
+    else
+      printf("perscoll test FAILED with %d errors\n", total);
+  }
+  MPI_Finalize();
+  return total != 0;
+}
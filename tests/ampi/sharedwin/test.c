@@ -0,0 +1,140 @@
+/*
+  A window from MPI_Win_allocate_shared stays usable while rank 0, which
+  owns its segment when all ranks share a process, moves to another PE of
+  that process and back. The other ranks keep storing into rank 0's part
+  of the segment while it migrates, and afterwards everything they stored,
+  and rank 0's own data, must still be there. Each process gets its own
+  window, and without a second PE in the process rank 0 stays put.
+
+  Ranks may share a process, so there is no mutable global state.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+
+#define ROUNDS 4
+#define MAX_RANKS 32        /* per process */
+#define DATA MAX_RANKS      /* first int of rank 0's own data */
+#define SLOTS (2*MAX_RANKS) /* ints in each rank's part */
+
+typedef struct {
+  int rank, size, errors;
+} Ctx;
+
+static void check(Ctx *c, int cond, const char *what, int round)
+{
+  if (!cond) {
+    printf("[%d] %s failed in round %d\n", c->rank, what, round);
+    c->errors++;
+  }
+}
+
+/* AMPI stores these attributes by value, see tests/ampi/megampi */
+static int worldAttr(int key)
+{
+  int val, flag;
+  MPI_Comm_get_attr(MPI_COMM_WORLD, key, &val, &flag);
+  return val;
+}
+
+/* Another PE of this process, or -1 if it has only one */
+static int otherLocalPe(void)
+{
+  int pe = worldAttr(AMPI_MY_WTH);
+  int ppn = worldAttr(AMPI_NUM_WTHS) / worldAttr(AMPI_NUM_PROCESSES);
+  int first = pe - pe % ppn;
+  if (ppn < 2) return -1;
+  return (pe == first) ? first + 1 : first;
+}
+
+int main(int argc, char **argv)
+{
+  Ctx c = {0, 0, 0};
+  MPI_Comm proc;
+  MPI_Win win;
+  MPI_Aint qsize;
+  int *mine, *part0, disp, i, round, total, home, away;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_split_type(MPI_COMM_WORLD, AMPI_COMM_TYPE_PROCESS, 0, MPI_INFO_NULL, &proc);
+  MPI_Comm_rank(proc, &c.rank);
+  MPI_Comm_size(proc, &c.size);
+  if (c.size > MAX_RANKS) {
+    if (c.rank == 0) printf("sharedwin test needs at most %d ranks per process\n", MAX_RANKS);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  MPI_Win_allocate_shared(SLOTS * sizeof(int), sizeof(int), MPI_INFO_NULL, proc, &mine, &win);
+  MPI_Win_shared_query(win, 0, &qsize, &disp, &part0);
+  for (i = 0; i < SLOTS; i++) mine[i] = (c.rank == 0 && i >= DATA) ? 1000 + i : 0;
+  home = worldAttr(AMPI_MY_WTH);
+  away = otherLocalPe();
+  MPI_Win_sync(win);
+  MPI_Barrier(proc);
+
+  for (round = 0; round < ROUNDS; round++) {
+    volatile int *flag = part0;
+    int stores = 0, got = -1, val = -c.rank;
+    int *oldMine = mine;
+
+    if (c.rank == 0) {
+      if (away >= 0) {
+        AMPI_Migrate_to_pe(round % 2 == 0 ? away : home);
+        check(&c, worldAttr(AMPI_MY_WTH) == (round % 2 == 0 ? away : home), "Migrate_to_pe", round);
+      }
+      *flag = round + 1;
+      MPI_Win_sync(win);
+    }
+    else {
+      /* Keep storing into rank 0's part until it is back */
+      while (*flag != round + 1) {
+        part0[c.rank] = ++stores;
+        MPI_Win_sync(win);
+        AMPI_Yield();
+      }
+      part0[c.rank] = ++stores;
+    }
+    MPI_Win_sync(win);
+    MPI_Barrier(proc);
+    MPI_Win_sync(win);
+
+    check(&c, mine == oldMine, "base address", round);
+    if (c.rank == 0) {
+      for (i = DATA; i < SLOTS; i++)
+        check(&c, mine[i] == 1000 + i, "rank 0 data", round);
+    }
+    else {
+      check(&c, part0[c.rank] == stores, "stores during migration", round);
+    }
+
+    /* RMA calls must reach the segment as well */
+    MPI_Win_fence(0, win);
+    if (c.rank != 0) {
+      MPI_Put(&val, 1, MPI_INT, 0, c.rank, 1, MPI_INT, win);
+      MPI_Get(&got, 1, MPI_INT, 0, DATA, 1, MPI_INT, win);
+    }
+    MPI_Win_fence(0, win);
+    if (c.rank == 0) {
+      for (i = 1; i < c.size; i++)
+        check(&c, mine[i] == -i, "MPI_Put", round);
+    }
+    else {
+      check(&c, got == 1000 + DATA, "MPI_Get", round);
+    }
+    MPI_Barrier(proc);
+  }
+
+  MPI_Win_free(&win);
+  MPI_Comm_free(&proc);
+
+  MPI_Allreduce(&c.errors, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &c.rank);
+  if (c.rank == 0) {
+    if (total == 0)
+      printf("sharedwin test passed\n");
+    else
+      printf("sharedwin test FAILED with %d errors\n", total);
+  }
+  MPI_Finalize();
+  return total != 0;
+}